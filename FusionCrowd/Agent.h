@@ -22,6 +22,10 @@ namespace FusionCrowd
 
 		Goal currentGoal;
 
+		// Neighbour cap set through UpdateMaxNeighbors, survives operation component switches
+		bool hasMaxNeighbors = false;
+		size_t maxNeighbors = 0;
+
 		size_t GetGroupId() const;
 		void SetGroupId(size_t newGroupId);
 	private:
@@ -360,11 +360,12 @@ namespace FusionCrowd
 
 		float Ellipse::RadiusInPointDirection(const DirectX::SimpleMath::Vector2& pt) const
 		{
-			Vector2 p = ToEllipseSpace(pt);
 			Vector2 dir;
-			p.Normalize(p);
-			Vector2 boundPoint(_majorAxis * dir.x, _minorAxis * dir.y);
-			return boundPoint.Length();
+			ToEllipseSpace(pt).Normalize(dir);
+			// distance from the center to the boundary along dir
+			const float x = dir.x / _majorAxis;
+			const float y = dir.y / _minorAxis;
+			return 1.f / sqrtf(x * x + y * y);
 		}
 
 		float Ellipse::RadiusInDirection(const DirectX::SimpleMath::Vector2& dir) const
@@ -24,6 +24,8 @@ namespace FusionCrowd
 			}
 
 			float DistanceOfClosestApproach(const Ellipse& other) const;
+			// Sum of both radii along the line between centers. Underestimates the exact value
+			// by at most the sum of both axis differences, exact for circles.
 			float ApproxDistanceOfClosestApproach(const Ellipse& other) const;
 			DirectX::SimpleMath::Vector2 ClosestPoint(const DirectX::SimpleMath::Vector2& pt) const;
 			float MinimumDistance(const Obstacle* line, DirectX::SimpleMath::Vector2& dir) const;
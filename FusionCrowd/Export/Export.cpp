@@ -127,6 +127,41 @@ namespace FusionCrowd
 			return _sim->UpdateNeighbourSearchShape(agentId, cone);
 		}
 
+		bool UpdateMaxNeighbors(size_t agentId, size_t maxNeighbors)
+		{
+			return _sim->UpdateMaxNeighbors(agentId, maxNeighbors);
+		}
+
+		void SetReplanBudget(size_t microseconds)
+		{
+			_sim->SetReplanBudget(microseconds);
+		}
+
+		ReplanQueueStats GetReplanQueueStats() const
+		{
+			return _sim->GetReplanQueueStats();
+		}
+
+		float GetAgentPlanWait(size_t agentId) const
+		{
+			return _sim->GetAgentPlanWait(agentId);
+		}
+
+		void SetRouteCacheBudget(size_t bytes)
+		{
+			_sim->SetRouteCacheBudget(bytes);
+		}
+
+		RouteCacheStats GetRouteCacheStats() const
+		{
+			return _sim->GetRouteCacheStats();
+		}
+
+		bool SetGcfDistanceAccuracy(float absoluteError, float relativeError)
+		{
+			return _sim->SetGcfDistanceAccuracy(absoluteError, relativeError);
+		}
+
 
 		OperationStatus UpdateSpecialOpParams(size_t agentId, StrictOCParams params) {
 			return _sim->UpdateSpecialOpParams(agentId, params);
@@ -356,6 +391,12 @@ namespace FusionCrowd
 			return this;
 		}
 
+		ISimulatorBuilder* WithThreadCount(size_t threadCount)
+		{
+			sim->SetThreadCount(threadCount);
+			return this;
+		}
+
 		ComponentId WithExternalStrategy(StrategyFactory externalStrategyFactory, IStrategyComponent ** outStrategy)
 		{
 			ComponentId newId = nextExternalStrategyId++;
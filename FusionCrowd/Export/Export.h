@@ -47,6 +47,29 @@ namespace FusionCrowd
 			ComponentId tacticCompId;
 		};
 
+		// NavMesh replanning queue after the last step, waits are in simulation seconds
+		struct FUSION_CROWD_API ReplanQueueStats
+		{
+			// Agents still waiting for a route
+			size_t queueLength;
+			// Agents that got a route during the step
+			size_t planned;
+			float meanWait;
+			float maxWait;
+		};
+
+		// Route cache of the NavMesh path planner, counted since the simulator was created
+		struct FUSION_CROWD_API RouteCacheStats
+		{
+			size_t hits;
+			size_t misses;
+			size_t evictions;
+			// Routes and their approximate size in bytes held by the cache
+			size_t routes;
+			size_t bytesUsed;
+			size_t byteBudget;
+		};
+
 		struct FUSION_CROWD_API SpecialOCParams {};
 
 		struct FUSION_CROWD_API StrictOCParams : SpecialOCParams {
@@ -119,6 +142,29 @@ namespace FusionCrowd
 
 			virtual INavMeshPublic* GetNavMesh() const = 0;
 			virtual INavSystemPublic* GetNavSystem() const = 0;
+
+			// Added methods go last so that the vtable layout of existing ones does not change
+
+			// Caps the neighbours the agent's operation component sees, overrides the cap of the component
+			// and is kept when the agent switches to another one
+			virtual bool UpdateMaxNeighbors(size_t agentId, size_t maxNeighbors) = 0;
+
+			// Wall time NavMesh replanning may take per step in microseconds, 0 for no limit.
+			// Agents left in the queue steer straight to their goals until their routes arrive.
+			virtual void SetReplanBudget(size_t microseconds) = 0;
+			virtual ReplanQueueStats GetReplanQueueStats() const = 0;
+			// Time the agent has been waiting for its route, or waited for the last one
+			virtual float GetAgentPlanWait(size_t agentId) const = 0;
+
+			// Routes over the budget are evicted, least recently used first.
+			// Agents keep following evicted routes they already have.
+			virtual void SetRouteCacheBudget(size_t bytes) = 0;
+			virtual RouteCacheStats GetRouteCacheStats() const = 0;
+
+			// Largest error GCF may accept from its approximate ellipse distance of closest approach,
+			// absolute in metres and relative to the distance between ellipses. Both at 0 keep it to
+			// circles only. Returns false if the simulator has no GCF component.
+			virtual bool SetGcfDistanceAccuracy(float absoluteError, float relativeError) = 0;
 		};
 
 		/*
@@ -145,6 +191,9 @@ namespace FusionCrowd
 			virtual ComponentId WithExternalStrategy(StrategyFactory externalStrategyFactory, IStrategyComponent ** outStrategy) = 0;
 
 			virtual ISimulatorFacade* Build() = 0;
+
+			// Threads used by the simulation including the calling one, 0 means hardware concurrency
+			virtual ISimulatorBuilder* WithThreadCount(size_t threadCount) = 0;
 		};
 
 		/*
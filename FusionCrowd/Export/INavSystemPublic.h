@@ -6,11 +6,40 @@
 
 namespace FusionCrowd
 {
+	enum FUSION_CROWD_API NeighbourSearchMode
+	{
+		// Persistent hash grid with a vector of agents per cell
+		HashedGrid,
+		// Agents sorted by cell into one array with an offset table per cell
+		CountingSort,
+	};
+
+	struct FUSION_CROWD_API NeighbourSearchStats
+	{
+		size_t steps = 0;
+		// Full searches; equals steps when Verlet lists are disabled
+		size_t rebuilds = 0;
+		// Largest agent displacement since the last Verlet rebuild
+		float maxDisplacement = 0.f;
+	};
+
 	class FUSION_CROWD_API INavSystemPublic
 	{
 	public:
 		virtual INavMeshPublic* GetPublicNavMesh() const = 0;
 
 		virtual float CutPolygonFromMesh(FCArray<NavMeshVetrex> & polygon) = 0;
+
+		virtual void SetNeighbourSearchMode(NeighbourSearchMode mode) = 0;
+		virtual NeighbourSearchMode GetNeighbourSearchMode() const = 0;
+
+		// Threads used by the simulation, including the calling thread
+		virtual void SetThreadCount(size_t threadCount) = 0;
+		virtual size_t GetThreadCount() const = 0;
+
+		// Extra radius of Verlet neighbour lists, 0 disables them
+		virtual void SetNeighbourSkin(float skin) = 0;
+		virtual float GetNeighbourSkin() const = 0;
+		virtual NeighbourSearchStats GetNeighbourSearchStats() const = 0;
 	};
 }
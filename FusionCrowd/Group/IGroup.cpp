@@ -14,10 +14,10 @@ namespace FusionCrowd
 		const Vector2 targetPos = dummyInfo.GetPos() + dummyInfo.GetVel() * timeStep + rotRelativePos;
 		Vector2 dir = targetPos - agentInfo.GetPos();
 
-		agentInfo.prefVelocity.setSpeed(dir.Length() / timeStep);
+		agentInfo.GetPrefVelocity().setSpeed(dir.Length() / timeStep);
 
 		dir.Normalize();
-		agentInfo.prefVelocity.setSingle(dir);
+		agentInfo.GetPrefVelocity().setSingle(dir);
 	}
 
 	size_t IGroup::GetDummyId() const
@@ -5,6 +5,8 @@
 #include "SimpleMath.h"
 #undef NOMINMAX
 
+#include <cstdint>
+
 namespace FusionCrowd
 {
 	namespace Math
@@ -62,5 +64,21 @@ namespace FusionCrowd
 
 			return DirectX::SimpleMath::Vector2::Distance(p, projection);
 		}
+
+		// Interleaves bits of two 16 bit coordinates
+		inline uint32_t MortonCode(uint32_t x, uint32_t y)
+		{
+			auto spread = [](uint32_t v)
+			{
+				v &= 0x0000FFFF;
+				v = (v | (v << 8)) & 0x00FF00FF;
+				v = (v | (v << 4)) & 0x0F0F0F0F;
+				v = (v | (v << 2)) & 0x33333333;
+				v = (v | (v << 1)) & 0x55555555;
+				return v;
+			};
+
+			return spread(x) | (spread(y) << 1);
+		}
 	}
 }
\ No newline at end of file
@@ -6,101 +6,129 @@ using namespace DirectX::SimpleMath;
 
 namespace FusionCrowd
 {
+	const size_t AgentSpatialInfo::NO_NEIGHBOR_LIMIT;
+
 	AgentSpatialInfo::AgentSpatialInfo() : neighbourSearchShape(std::make_unique<Math::DiskShape>(Vector2(0.f, 0.f), 4.0f))
 	{ }
 
+	// Copies hold their own state, the copied record may be a view of the store
 	AgentSpatialInfo::AgentSpatialInfo(const AgentSpatialInfo& other) :
 		id(other.id),
-		pos(other.pos),
-		vel(other.vel),
-		velNew(other.velNew),
-		orient(other.orient),
 		radius(other.radius),
 		maxSpeed(other.maxSpeed),
+		maxAccel(other.maxAccel),
 		prefSpeed(other.prefSpeed),
 		maxAngVel(other.maxAngVel),
 		inertiaEnabled(other.inertiaEnabled),
 		type(other.type),
 		collisionsLevel(other.collisionsLevel),
-		prefVelocity(other.prefVelocity),
 		neighbourSearchShape(std::unique_ptr<Math::Geometry2D>(other.neighbourSearchShape->Clone())),
-		useNavMeshObstacles(other.useNavMeshObstacles)
+		useNavMeshObstacles(other.useNavMeshObstacles),
+		maxNeighbors(other.maxNeighbors),
+		pos(other.GetPos()),
+		vel(other.GetVel()),
+		orient(other.GetOrient()),
+		velNew(other.GetVelNew()),
+		prefVelocity(other.GetPrefVelocity())
 	{ }
 
+	// Assigning to a record in the store writes its slot
 	AgentSpatialInfo & AgentSpatialInfo::operator=(const AgentSpatialInfo & other)
 	{
 		id  = other.id;
-		pos = other.pos;
-		vel = other.vel;
-		velNew = other.velNew;
-		orient = other.orient;
 		radius = other.radius;
 		maxSpeed  = other.maxSpeed;
+		maxAccel  = other.maxAccel;
 		prefSpeed = other.prefSpeed;
 		maxAngVel = other.maxAngVel;
 		inertiaEnabled = other.inertiaEnabled;
 		type = other.type;
 		collisionsLevel = other.collisionsLevel;
-		prefVelocity = other.prefVelocity;
 		neighbourSearchShape = std::unique_ptr<Math::Geometry2D>(other.neighbourSearchShape->Clone());
 		useNavMeshObstacles = other.useNavMeshObstacles;
+		maxNeighbors = other.maxNeighbors;
+
+		const Vector2 otherVel = other.GetVel();
+		const Vector2 otherOrient = other.GetOrient();
+		SetPos(other.GetPos());
+		SetVelNew(other.GetVelNew());
+		GetPrefVelocity() = other.GetPrefVelocity();
+		if(_columns)
+		{
+			_columns->vel[_slot] = otherVel;
+			_columns->orient[_slot] = otherOrient;
+		}
+		else
+		{
+			vel = otherVel;
+			orient = otherOrient;
+		}
 
 		return *this;
 	}
 
-	AgentSpatialInfo::AgentSpatialInfo(AgentSpatialInfo && other):
+	// Moves keep the store view, AgentStore fixes the slot when it moves records
+	AgentSpatialInfo::AgentSpatialInfo(AgentSpatialInfo && other) noexcept :
 		id(other.id),
-		pos(other.pos),
-		vel(other.vel),
-		velNew(other.velNew),
-		orient(other.orient),
 		radius(other.radius),
 		maxSpeed(other.maxSpeed),
+		maxAccel(other.maxAccel),
 		prefSpeed(other.prefSpeed),
 		maxAngVel(other.maxAngVel),
 		inertiaEnabled(other.inertiaEnabled),
 		type(other.type),
 		collisionsLevel(other.collisionsLevel),
-		prefVelocity(other.prefVelocity),
 		neighbourSearchShape(std::move(other.neighbourSearchShape)),
-		useNavMeshObstacles(other.useNavMeshObstacles)
+		specialOPParams(std::move(other.specialOPParams)),
+		useNavMeshObstacles(other.useNavMeshObstacles),
+		maxNeighbors(other.maxNeighbors),
+		_isOverlaping(other._isOverlaping),
+		pos(other.pos),
+		vel(other.vel),
+		orient(other.orient),
+		velNew(other.velNew),
+		prefVelocity(other.prefVelocity),
+		_columns(other._columns),
+		_slot(other._slot)
 	{ }
 
-	AgentSpatialInfo & AgentSpatialInfo::operator=(AgentSpatialInfo && other)
+	AgentSpatialInfo & AgentSpatialInfo::operator=(AgentSpatialInfo && other) noexcept
 	{
 		id  = other.id;
-		pos = other.pos;
-		vel = other.vel;
-		velNew = other.velNew;
-		orient = other.orient;
 		radius = other.radius;
 		maxSpeed  = other.maxSpeed;
+		maxAccel  = other.maxAccel;
 		prefSpeed = other.prefSpeed;
 		maxAngVel = other.maxAngVel;
 		inertiaEnabled = other.inertiaEnabled;
 		type = other.type;
 		collisionsLevel = other.collisionsLevel;
-		prefVelocity = other.prefVelocity;
 		neighbourSearchShape = std::move(other.neighbourSearchShape);
+		specialOPParams = std::move(other.specialOPParams);
 		useNavMeshObstacles = other.useNavMeshObstacles;
+		maxNeighbors = other.maxNeighbors;
+		_isOverlaping = other._isOverlaping;
+		pos = other.pos;
+		vel = other.vel;
+		orient = other.orient;
+		velNew = other.velNew;
+		prefVelocity = other.prefVelocity;
+		_columns = other._columns;
+		_slot = other._slot;
 
 		return *this;
 	}
 
 	void AgentSpatialInfo::SetPos(Vector2 pos)
 	{
-		this->pos = pos;
+		if(_columns)
+			_columns->pos[_slot] = pos;
+		else
+			this->pos = pos;
 	}
 
 	void AgentSpatialInfo::setOverlaping(bool newVal)
 	{
 		_isOverlaping = newVal;
 	}
-
-	void AgentSpatialInfo::Update(Vector2 pos, Vector2 vel, Vector2 orient)
-	{
-		this->pos    = pos;
-		this->vel    = vel;
-		this->orient = orient;
-	}
 }
\ No newline at end of file
@@ -5,10 +5,25 @@
 #include "Export/IRecording.h"
 #include "Export/Export.h"
 
+#include <limits>
 #include <memory>
+#include <vector>
 
 namespace FusionCrowd
 {
+	// Per-slot agent state owned by AgentStore
+	struct AgentColumns
+	{
+		// Current state, read-only during a step
+		std::vector<DirectX::SimpleMath::Vector2> pos;
+		std::vector<DirectX::SimpleMath::Vector2> vel;
+		std::vector<DirectX::SimpleMath::Vector2> orient;
+
+		// Written during a step, each slot by its own agent only
+		std::vector<DirectX::SimpleMath::Vector2> velNew;
+		std::vector<Agents::PrefVelocity> prefVelocity;
+	};
+
 	struct AgentSpatialInfo
 	{
 	public:
@@ -17,6 +32,8 @@ namespace FusionCrowd
 		static const Type GROUP = 2;
 		static const Type COLLIDE_ALL = AGENT | GROUP;
 
+		static const size_t NO_NEIGHBOR_LIMIT = std::numeric_limits<size_t>::max();
+
 		inline bool CanCollide(const AgentSpatialInfo & target) const
 		{
 			return (collisionsLevel & target.type) != 0;
@@ -24,7 +41,6 @@ namespace FusionCrowd
 
 	public:
 		size_t id;
-		DirectX::SimpleMath::Vector2 velNew;
 
 		float radius    = 0.19f;
 		float maxSpeed  = 2.f;
@@ -37,41 +53,56 @@ namespace FusionCrowd
 		Type type = AGENT;
 		Type collisionsLevel = COLLIDE_ALL;
 
-		Agents::PrefVelocity prefVelocity = Agents::PrefVelocity(DirectX::SimpleMath::Vector2(1.f, 0.f), prefSpeed, DirectX::SimpleMath::Vector2(0.f, 0.f));
-
 		std::unique_ptr<Math::Geometry2D> neighbourSearchShape;
 		std::unique_ptr <SpecialOCParams> specialOPParams;
 
 		bool useNavMeshObstacles = true;
 
+		// Neighbour search keeps only this many nearest agents
+		size_t maxNeighbors = NO_NEIGHBOR_LIMIT;
+
 	public:
 		AgentSpatialInfo();
 
 		AgentSpatialInfo(const AgentSpatialInfo & other);
 		AgentSpatialInfo & operator=(const AgentSpatialInfo & other);
 
-		AgentSpatialInfo(AgentSpatialInfo && other);
-		AgentSpatialInfo & operator=(AgentSpatialInfo && other);
+		AgentSpatialInfo(AgentSpatialInfo && other) noexcept;
+		AgentSpatialInfo & operator=(AgentSpatialInfo && other) noexcept;
 
-		inline DirectX::SimpleMath::Vector2 GetPos()    const { return pos; }
-		inline DirectX::SimpleMath::Vector2 GetVel()    const { return vel; }
-		inline DirectX::SimpleMath::Vector2 GetOrient() const { return orient; }
+		// Once added to AgentStore the record is a view of its slot in the store columns
+		inline DirectX::SimpleMath::Vector2 GetPos()    const { return _columns ? _columns->pos[_slot] : pos; }
+		inline DirectX::SimpleMath::Vector2 GetVel()    const { return _columns ? _columns->vel[_slot] : vel; }
+		inline DirectX::SimpleMath::Vector2 GetOrient() const { return _columns ? _columns->orient[_slot] : orient; }
+		inline DirectX::SimpleMath::Vector2 GetVelNew() const { return _columns ? _columns->velNew[_slot] : velNew; }
+
+		inline Agents::PrefVelocity & GetPrefVelocity() { return _columns ? _columns->prefVelocity[_slot] : prefVelocity; }
+		inline const Agents::PrefVelocity & GetPrefVelocity() const { return _columns ? _columns->prefVelocity[_slot] : prefVelocity; }
 
 		void SetPos(DirectX::SimpleMath::Vector2 pos);
 
-		void Update(
-			DirectX::SimpleMath::Vector2 pos,
-			DirectX::SimpleMath::Vector2 vel,
-			DirectX::SimpleMath::Vector2 orient
-		);
+		inline void SetVelNew(DirectX::SimpleMath::Vector2 vel)
+		{
+			if(_columns)
+				_columns->velNew[_slot] = vel;
+			else
+				velNew = vel;
+		}
 
 		inline bool isOverlaping() const { return _isOverlaping; };
 		void setOverlaping(bool newVal);
 
 	private:
+		friend class AgentStore;
+
 		bool _isOverlaping = false;
 		DirectX::SimpleMath::Vector2 pos;
 		DirectX::SimpleMath::Vector2 vel;
 		DirectX::SimpleMath::Vector2 orient = DirectX::SimpleMath::Vector2(1.f, 0.f);
+		DirectX::SimpleMath::Vector2 velNew;
+		Agents::PrefVelocity prefVelocity = Agents::PrefVelocity(DirectX::SimpleMath::Vector2(1.f, 0.f), prefSpeed, DirectX::SimpleMath::Vector2(0.f, 0.f));
+
+		AgentColumns * _columns = nullptr;
+		size_t _slot = 0;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,136 @@
+#include "AgentStore.h"
+
+#include <utility>
+
+using namespace DirectX::SimpleMath;
+
+namespace FusionCrowd
+{
+	const size_t AgentStore::NO_SLOT;
+
+	bool AgentStore::Add(AgentSpatialInfo info)
+	{
+		const size_t id = info.id;
+		if(Contains(id))
+			return false;
+
+		if(id >= _sparse.size())
+			_sparse.resize(id + 1, NO_SLOT);
+
+		const size_t slot = _ids.size();
+
+		_columns.pos.push_back(info.GetPos());
+		_columns.vel.push_back(info.GetVel());
+		_columns.orient.push_back(info.GetOrient());
+		_columns.velNew.push_back(info.GetVelNew());
+		_columns.prefVelocity.push_back(info.GetPrefVelocity());
+		_radius.push_back(info.radius);
+
+		_nextPos.emplace_back();
+		_nextVel.emplace_back();
+		_nextOrient.emplace_back();
+		_nextRadius.emplace_back();
+
+		info._columns = &_columns;
+		info._slot = slot;
+
+		_sparse[id] = slot;
+		_ids.push_back(id);
+		_info.push_back(std::move(info));
+		_neighbours.emplace_back();
+		_obstacles.emplace_back();
+		_navNodes.push_back(std::numeric_limits<unsigned int>::max());
+
+		return true;
+	}
+
+	bool AgentStore::Remove(size_t agentId)
+	{
+		if(!Contains(agentId))
+			return false;
+
+		const size_t slot = _sparse[agentId];
+		const size_t last = _ids.size() - 1;
+
+		if(slot != last)
+		{
+			const size_t movedId = _ids[last];
+
+			_ids[slot]        = movedId;
+			_info[slot]       = std::move(_info[last]);
+			_neighbours[slot] = std::move(_neighbours[last]);
+			_obstacles[slot]  = std::move(_obstacles[last]);
+			_navNodes[slot]   = _navNodes[last];
+			_radius[slot]     = _radius[last];
+			_nextPos[slot]    = _nextPos[last];
+			_nextVel[slot]    = _nextVel[last];
+			_nextOrient[slot] = _nextOrient[last];
+			_nextRadius[slot] = _nextRadius[last];
+
+			_columns.pos[slot]          = _columns.pos[last];
+			_columns.vel[slot]          = _columns.vel[last];
+			_columns.orient[slot]       = _columns.orient[last];
+			_columns.velNew[slot]       = _columns.velNew[last];
+			_columns.prefVelocity[slot] = _columns.prefVelocity[last];
+			_info[slot]._slot = slot;
+
+			_sparse[movedId] = slot;
+		}
+
+		_ids.pop_back();
+		_info.pop_back();
+		_neighbours.pop_back();
+		_obstacles.pop_back();
+		_navNodes.pop_back();
+		_radius.pop_back();
+		_nextPos.pop_back();
+		_nextVel.pop_back();
+		_nextOrient.pop_back();
+		_nextRadius.pop_back();
+		_columns.pos.pop_back();
+		_columns.vel.pop_back();
+		_columns.orient.pop_back();
+		_columns.velNew.pop_back();
+		_columns.prefVelocity.pop_back();
+
+		_sparse[agentId] = NO_SLOT;
+
+		return true;
+	}
+
+	bool AgentStore::Contains(size_t agentId) const
+	{
+		return agentId < _sparse.size() && _sparse[agentId] != NO_SLOT;
+	}
+
+	size_t AgentStore::GetSlot(size_t agentId) const
+	{
+		return agentId < _sparse.size() ? _sparse[agentId] : NO_SLOT;
+	}
+
+	AgentSpatialInfo & AgentStore::Get(size_t agentId)
+	{
+		return _info.at(GetSlot(agentId));
+	}
+
+	const AgentSpatialInfo & AgentStore::Get(size_t agentId) const
+	{
+		return _info.at(GetSlot(agentId));
+	}
+
+	void AgentStore::SyncRadii()
+	{
+		for(size_t slot = 0; slot < _info.size(); slot++)
+		{
+			_radius[slot] = _info[slot].radius;
+		}
+	}
+
+	void AgentStore::SwapBuffers()
+	{
+		_columns.pos.swap(_nextPos);
+		_columns.vel.swap(_nextVel);
+		_columns.orient.swap(_nextOrient);
+		_radius.swap(_nextRadius);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "Math/Util.h"
+#include "Navigation/AgentSpatialInfo.h"
+#include "Navigation/NeighborInfo.h"
+#include "Navigation/Obstacle.h"
+
+#include <limits>
+#include <vector>
+
+namespace FusionCrowd
+{
+	// Dense agent storage. Agents occupy slots [0, Size()) without holes,
+	// sparse-set maps agent id to slot so add and remove are O(1).
+	// Removing an agent moves the last one into its slot.
+	//
+	// Agent state lives in columns, records added to the store are views of their slot.
+	// Kinematic state is double-buffered: Positions/Velocities/Orientations are the
+	// current state, read-only during a step, while NavSystem::Update writes the next
+	// one with SetNext and publishes it with SwapBuffers.
+	class AgentStore
+	{
+	public:
+		static const size_t NO_SLOT = std::numeric_limits<size_t>::max();
+
+		AgentStore() = default;
+
+		// Records point into the columns of this store
+		AgentStore(const AgentStore &) = delete;
+		AgentStore & operator=(const AgentStore &) = delete;
+
+		bool Add(AgentSpatialInfo info);
+		bool Remove(size_t agentId);
+
+		bool Contains(size_t agentId) const;
+		size_t GetSlot(size_t agentId) const;
+
+		inline size_t Size() const { return _ids.size(); }
+		inline size_t IdAt(size_t slot) const { return _ids[slot]; }
+
+		AgentSpatialInfo & Get(size_t agentId);
+		const AgentSpatialInfo & Get(size_t agentId) const;
+
+		inline AgentSpatialInfo & At(size_t slot) { return _info[slot]; }
+		inline const AgentSpatialInfo & At(size_t slot) const { return _info[slot]; }
+
+		inline std::vector<NeighborInfo> & NeighboursAt(size_t slot) { return _neighbours[slot]; }
+		inline const std::vector<NeighborInfo> & NeighboursAt(size_t slot) const { return _neighbours[slot]; }
+
+		inline std::vector<Obstacle> & ObstaclesAt(size_t slot) { return _obstacles[slot]; }
+		inline const std::vector<Obstacle> & ObstaclesAt(size_t slot) const { return _obstacles[slot]; }
+
+		// Last known navmesh node of the agent, used as a hint by localisation
+		inline unsigned int & NavNodeAt(size_t slot) { return _navNodes[slot]; }
+		inline unsigned int NavNodeAt(size_t slot) const { return _navNodes[slot]; }
+
+		// Radius is a record field, copies it into the radius column
+		void SyncRadii();
+
+		inline const DirectX::SimpleMath::Vector2 * Positions()    const { return _columns.pos.data(); }
+		inline const DirectX::SimpleMath::Vector2 * Velocities()   const { return _columns.vel.data(); }
+		inline const DirectX::SimpleMath::Vector2 * Orientations() const { return _columns.orient.data(); }
+		inline const DirectX::SimpleMath::Vector2 * NewVelocities() const { return _columns.velNew.data(); }
+		inline const Agents::PrefVelocity * PrefVelocities() const { return _columns.prefVelocity.data(); }
+		inline const float * Radii() const { return _radius.data(); }
+
+		// Each slot may be written by one thread only, other slots are not touched
+		inline void SetNext(size_t slot, DirectX::SimpleMath::Vector2 pos, DirectX::SimpleMath::Vector2 vel, DirectX::SimpleMath::Vector2 orient)
+		{
+			_nextPos[slot] = pos;
+			_nextVel[slot] = vel;
+			_nextOrient[slot] = orient;
+			_nextRadius[slot] = _info[slot].radius;
+		}
+
+		// Makes next state current
+		void SwapBuffers();
+
+	private:
+		std::vector<size_t> _sparse;
+		std::vector<size_t> _ids;
+
+		std::vector<AgentSpatialInfo> _info;
+		std::vector<std::vector<NeighborInfo>> _neighbours;
+		std::vector<std::vector<Obstacle>> _obstacles;
+		std::vector<unsigned int> _navNodes;
+
+		AgentColumns _columns;
+		std::vector<float> _radius;
+
+		std::vector<DirectX::SimpleMath::Vector2> _nextPos;
+		std::vector<DirectX::SimpleMath::Vector2> _nextVel;
+		std::vector<DirectX::SimpleMath::Vector2> _nextOrient;
+		std::vector<float> _nextRadius;
+	};
+}
@@ -2,145 +2,352 @@
 
 #include "Math/consts.h"
 
-#include <unordered_map>
+#include <algorithm>
+#include <cmath>
 
 using namespace DirectX::SimpleMath;
 
 namespace FusionCrowd
 {
-	NeighborsSeeker::NeighborsSeeker() : _pool(std::thread::hardware_concurrency() - 1)
+	namespace
 	{
+		// Per-agent search state shared by both grid layouts
+		class AgentQuery
+		{
+		public:
+			AgentQuery(const AgentStore & agents, size_t slot, NeighborsSeeker::SearchResult & result) :
+				_agents(agents),
+				_agent(agents.At(slot)),
+				_slot(slot),
+				_pos(agents.Positions()[slot]),
+				_radius(agents.Radii()[slot]),
+				_result(result)
+			{
+				_result.agentId = _agent.id;
+				_result.neighbors.clear();
+				_result.isOverlapped = false;
+				_R = _agent.neighbourSearchShape->BoundingRadius();
+
+				//angle between agent orient and (1,0) vector
+				const Vector2 orient = _agent.GetOrient();
+				float angle = acos(orient.x / orient.Length());
+				angle = orient.y > 0 ? angle : angle + (orient.x > 0 ? -acos(0) : acos(0));
+				_cos = cos(angle);
+				_sin = sin(angle);
+			}
+
+			inline Vector2 GetPos() const { return _pos; }
+
+			// Keeps maxNeighbors nearest neighbours besides the agent itself, partial selection leaves them unordered
+			void Finish()
+			{
+				std::vector<NeighborInfo> & neighbors = _result.neighbors;
+				const size_t k = _agent.maxNeighbors;
+				if(neighbors.size() <= k)
+					return;
+
+				// The agent finds itself at distance 0, it must not take one of the k places
+				auto first = neighbors.begin();
+				const size_t id = _agent.id;
+				auto self = std::find_if(neighbors.begin(), neighbors.end(), [id] (const NeighborInfo & n) { return n.id == id; });
+				if(self != neighbors.end())
+				{
+					std::iter_swap(first, self);
+					++first;
+				}
+
+				if((size_t) (neighbors.end() - first) <= k)
+					return;
+
+				const Vector2 pos = _pos;
+				std::nth_element(first, first + k, neighbors.end(), [pos] (const NeighborInfo & a, const NeighborInfo & b)
+				{
+					return (a.pos - pos).LengthSquared() < (b.pos - pos).LengthSquared();
+				});
+				neighbors.erase(first + k, neighbors.end());
+			}
+			inline float GetSearchRadius() const { return _R; }
+
+			void Test(size_t nSlot, Vector2 nPos)
+			{
+				const AgentSpatialInfo & n = _agents.At(nSlot);
+
+				//transform to agent coordinates
+				const Vector2 translate = nPos - _pos;
+				Vector2 pointToCheck;
+				pointToCheck.x = translate.x * _cos - translate.y * _sin;
+				pointToCheck.y = translate.x * _sin + translate.y * _cos;
+				if(_agent.CanCollide(n) && _agent.neighbourSearchShape->containsPoint(pointToCheck))
+				{
+					_result.neighbors.push_back(NeighborInfo(n));
+				}
+
+				if(nSlot != _slot)
+				{
+					_result.isOverlapped = _result.isOverlapped || (translate.Length() < (_radius + _agents.Radii()[nSlot]));
+				}
+			}
+
+		private:
+			const AgentStore & _agents;
+			const AgentSpatialInfo & _agent;
+			size_t _slot;
+			Vector2 _pos;
+			float _radius;
+			float _R;
+			float _cos;
+			float _sin;
+
+			NeighborsSeeker::SearchResult & _result;
+		};
 	}
 
-	struct Cell
+	NeighborsSeeker::NeighborsSeeker() : _scheduler(std::make_shared<TaskScheduler>())
 	{
-		int x;
-		int y;
-	};
-
-	struct CellHash
-    {
-        size_t operator()(FusionCrowd::Cell const& c) const noexcept
-        {
-            return c.x ^ (c.y << 1);
-        }
-    };
-
-	bool operator==(const Cell & l, const Cell& r)
+	}
+
+	void NeighborsSeeker::SetVerletSkin(float skin)
 	{
-		return l.x == r.x && l.y == r.y;
+		_skin = std::max(skin, 0.f);
+		_candidatesValid = false;
 	}
 
-	struct Task
+	void NeighborsSeeker::InvalidateVerletLists()
 	{
-		size_t id;
-		std::future<NeighborsSeeker::SearchResult> result;
-	};
+		_candidatesValid = false;
+	}
 
-	std::vector<NeighborsSeeker::SearchResult> NeighborsSeeker::FindNeighborsCpu(std::vector<NeighborsSeeker::SearchRequest> searchRequests)
+	void NeighborsSeeker::FindNeighborsCpu(const AgentStore & agents, const SpatialGrid & grid, std::vector<SearchResult> & results)
 	{
-		std::vector<NeighborsSeeker::SearchResult> result;
+		const size_t n = agents.Size();
 
-		if(searchRequests.size() == 0)
-			return result;
+		// Existing entries are reused, so neighbour vectors keep their capacity between steps
+		results.resize(n);
+		_stats.steps++;
 
-		float minX = Math::INFTY, maxX = -Math::INFTY;
-		float minY = Math::INFTY, maxY = -Math::INFTY;
+		if(n == 0)
+			return;
+
+		if(_skin <= 0.f)
+		{
+			if(_mode == CountingSort)
+				BuildCellLists(agents);
+
+			_scheduler->ParallelFor(n, [this, &agents, &grid, &results] (size_t begin, size_t end)
+			{
+				for(size_t slot = begin; slot < end; slot++)
+				{
+					AgentQuery query(agents, slot, results[slot]);
+					ForEachCandidate(agents, grid, query.GetPos(), query.GetSearchRadius(), [&query] (size_t nSlot, Vector2 nPos)
+					{
+						query.Test(nSlot, nPos);
+					});
+					query.Finish();
+				}
+			});
+
+			_stats.rebuilds++;
+			return;
+		}
+
+		const bool rebuild = IsVerletRebuildNeeded(agents);
+		if(rebuild)
+		{
+			if(_mode == CountingSort)
+				BuildCellLists(agents);
+
+			_candidates.resize(n);
+			_candidatesPos.assign(agents.Positions(), agents.Positions() + n);
+			_candidatesRange.resize(n);
+			for(size_t i = 0; i < n; i++)
+			{
+				_candidatesRange[i] = agents.At(i).neighbourSearchShape->BoundingRadius();
+			}
+			_candidatesValid = true;
+			_stats.rebuilds++;
+		}
+
+		_scheduler->ParallelFor(n, [this, &agents, &grid, &results, rebuild] (size_t begin, size_t end)
+		{
+			const Vector2 * positions = agents.Positions();
+
+			for(size_t slot = begin; slot < end; slot++)
+			{
+				std::vector<size_t> & candidates = _candidates[slot];
+				AgentQuery query(agents, slot, results[slot]);
+
+				if(rebuild)
+				{
+					candidates.clear();
+
+					const Vector2 pos = query.GetPos();
+					const float range = query.GetSearchRadius() + _skin;
+					ForEachCandidate(agents, grid, pos, range, [&candidates, pos, range] (size_t nSlot, Vector2 nPos)
+					{
+						if((nPos - pos).LengthSquared() <= range * range)
+							candidates.push_back(nSlot);
+					});
+				}
+
+				for(size_t nSlot : candidates)
+				{
+					query.Test(nSlot, positions[nSlot]);
+				}
+				query.Finish();
+			}
+		});
+	}
 
-		for(const auto& r : searchRequests)
+	bool NeighborsSeeker::IsVerletRebuildNeeded(const AgentStore & agents)
+	{
+		const size_t n = agents.Size();
+		if(!_candidatesValid || _candidatesPos.size() != n)
+			return true;
+
+		const Vector2 * positions = agents.Positions();
+		const float threshold = 0.5f * _skin;
+
+		float maxDisplacementSq = 0.f;
+		for(size_t i = 0; i < n; i++)
 		{
-			const Vector2 pos = r.GetPos();
-			if(pos.x < minX)
-				minX = pos.x;
+			// Search shape has been replaced since the lists were built
+			if(agents.At(i).neighbourSearchShape->BoundingRadius() != _candidatesRange[i])
+				return true;
 
-			if(pos.x > maxX)
-				maxX = pos.x;
+			maxDisplacementSq = std::max(maxDisplacementSq, (positions[i] - _candidatesPos[i]).LengthSquared());
+		}
 
-			if(pos.y < minY)
-				minY = pos.y;
+		_stats.maxDisplacement = sqrtf(maxDisplacementSq);
+
+		return maxDisplacementSq > threshold * threshold;
+	}
 
-			if(pos.y > maxY)
-				maxY = pos.y;
+	void NeighborsSeeker::BuildCellLists(const AgentStore & agents)
+	{
+		const size_t n = agents.Size();
+		const Vector2 * positions = agents.Positions();
+
+		float minX = Math::INFTY, maxX = -Math::INFTY;
+		float minY = Math::INFTY, maxY = -Math::INFTY;
+
+		for(size_t i = 0; i < n; i++)
+		{
+			minX = std::min(minX, positions[i].x);
+			maxX = std::max(maxX, positions[i].x);
+			minY = std::min(minY, positions[i].y);
+			maxY = std::max(maxY, positions[i].y);
 		}
 
-		// Total cells             = n^(1/4) * n^(1/4) = n*(1/2)
-		// Avg agents in each cell = n / totalCells    = n^(1/2)
-		// Search complexity using cells = O(n^(1/2) * n^(1/2) * searchR^2) = O(n)
-		// Overall neighbours search complexity = totalCells * searchCmplxInCell = O(n^(1/2) * n) = O(n^3/2)
-		const size_t cellsAlongDimension = sqrt(sqrt(searchRequests.size())) + 1;
+		// Cells are not smaller than the largest search radius, so a search touches 3x3 cells.
+		// Sparse crowds in large worlds get coarser cells to keep the offset table ~O(n).
+		const float width  = maxX - minX;
+		const float height = maxY - minY;
+		const float maxCells = 4.f * n + 16.f;
+
+		_cellSize = std::max({
+			SpatialGrid::MaxSearchRadius(agents),
+			sqrtf(width * height / maxCells),
+			std::max(width, height) / maxCells
+		});
+		_origin = Vector2(minX, minY);
+		_cellsX = (int) (width  / _cellSize) + 1;
+		_cellsY = (int) (height / _cellSize) + 1;
 
-		const int cellSizeX = (maxX - minX) / cellsAlongDimension;
-		const int cellSizeY = (maxY - minY) / cellsAlongDimension;
+		const size_t cellCount = (size_t) _cellsX * _cellsY;
 
-		std::unordered_map<Cell, std::vector<SearchRequest>, CellHash> grid;
+		// Counting sort by cell index
+		_agentCell.resize(n);
+		_cellStart.assign(cellCount + 1, 0);
 
-		for(const auto& r : searchRequests)
+		for(size_t i = 0; i < n; i++)
 		{
-			const int x = r.GetPos().x / cellSizeX;
-			const int y = r.GetPos().y / cellSizeY;
+			const int x = std::min((int) ((positions[i].x - minX) / _cellSize), _cellsX - 1);
+			const int y = std::min((int) ((positions[i].y - minY) / _cellSize), _cellsY - 1);
+			const size_t cell = (size_t) y * _cellsX + x;
 
-			grid[{x, y}].push_back(r);
+			_agentCell[i] = cell;
+			_cellStart[cell + 1]++;
+		}
+
+		for(size_t c = 0; c < cellCount; c++)
+		{
+			_cellStart[c + 1] += _cellStart[c];
 		}
 
-		std::vector<Task> tasks;
+		_sortedSlots.resize(n);
+		_sortedPos.resize(n);
 
-		for(size_t i = 0; i < searchRequests.size(); i++)
+		// Fill cells back to front, so that slots stay in ascending order inside every cell.
+		// Afterwards _cellStart[c + 1] holds the beginning of cell c.
+		for(size_t i = n; i-- > 0;)
 		{
-			auto lambda = [&grid, &reqs=searchRequests, reqIdx=i, cellSizeX, cellSizeY] (int threadId)
-			{
-				const SearchRequest& r = reqs.at(reqIdx);
-				SearchResult result;
-				result.agentId = r.id;
+			const size_t idx = --_cellStart[_agentCell[i] + 1];
 
-				const float R = r.neighbourSearchShape->BoundingRadius();
-				const Vector2 pos = r.GetPos();
+			_sortedSlots[idx] = i;
+			_sortedPos[idx] = positions[i];
+		}
 
-				int minCellX = (pos.x - R) / cellSizeX;
-				int maxCellX = (pos.x + R) / cellSizeX + 1;
+		for(size_t c = 0; c < cellCount; c++)
+		{
+			_cellStart[c] = _cellStart[c + 1];
+		}
+		_cellStart[cellCount] = n;
+	}
 
-				int minCellY = (pos.y - R) / cellSizeY;
-				int maxCellY = (pos.y + R) / cellSizeY + 1;
+	template <typename Func>
+	void NeighborsSeeker::ForEachCandidate(const AgentStore & agents, const SpatialGrid & grid, Vector2 pos, float range, Func func) const
+	{
+		if(_mode == CountingSort)
+			ScanCellLists(pos, range, func);
+		else
+			ScanGrid(agents, grid, pos, range, func);
+	}
+
+	template <typename Func>
+	void NeighborsSeeker::ScanGrid(const AgentStore & agents, const SpatialGrid & grid, Vector2 pos, float range, Func & func) const
+	{
+		const Vector2 * positions = agents.Positions();
 
-				for(int x = minCellX; x <= maxCellX; x++)
+		const SpatialGrid::Cell minCell = grid.GetCell(pos - Vector2(range, range));
+		const SpatialGrid::Cell maxCell = grid.GetCell(pos + Vector2(range, range));
+
+		for(int x = minCell.x; x <= maxCell.x; x++)
+		{
+			for(int y = minCell.y; y <= maxCell.y; y++)
+			{
+				const std::vector<size_t> * cell = grid.GetCellAgents({x, y});
+				if(cell == nullptr)
+					continue;
+
+				for(size_t nId : *cell)
 				{
-					for(int y = minCellY; y <= maxCellY; y++)
-					{
-						const auto& cell = grid.find({x, y});
-						if(cell == grid.end())
-							continue;
-
-						for(auto & n : cell->second)
-						{
-							//transform to agent coordinates
-							auto translate = n.GetPos() - pos;
-							//angle between agent orient and (1,0) vector
-							auto orient = r.GetOrient();
-							float angle = acos(orient.x / orient.Length());
-							angle = orient.y > 0 ? angle : angle + (orient.x > 0 ? -acos(0) : acos(0));
-							auto pointToCheck = translate;
-							pointToCheck.x = translate.x * cos(angle) - translate.y * sin(angle);
-							pointToCheck.y = translate.x * sin(angle) + translate.y * cos(angle);
-							if(r.CanCollide(n) && r.neighbourSearchShape->containsPoint(pointToCheck))
-							{
-								result.neighbors.push_back(NeighborInfo(n));
-							}
-
-							result.isOverlapped = result.isOverlapped || (Vector2::Distance(r.GetPos(), n.GetPos()) < (r.radius + n.radius));
-						}
-					}
+					const size_t nSlot = agents.GetSlot(nId);
+					func(nSlot, positions[nSlot]);
 				}
+			}
+		}
+	}
 
-				return result;
-			};
+	template <typename Func>
+	void NeighborsSeeker::ScanCellLists(Vector2 pos, float range, Func & func) const
+	{
+		pos -= _origin;
 
-			tasks.push_back({searchRequests[i].id, _pool.push(lambda)});
-		}
+		const int minX = std::max((int) std::floor((pos.x - range) / _cellSize), 0);
+		const int maxX = std::min((int) std::floor((pos.x + range) / _cellSize), _cellsX - 1);
+		const int minY = std::max((int) std::floor((pos.y - range) / _cellSize), 0);
+		const int maxY = std::min((int) std::floor((pos.y + range) / _cellSize), _cellsY - 1);
 
-		for(auto & t : tasks)
+		for(int y = minY; y <= maxY; y++)
 		{
-			result.push_back(t.result.get());
-		}
+			// Cells of one row are adjacent in the sorted array, scan them as a single run
+			const size_t rowBegin = _cellStart[(size_t) y * _cellsX + minX];
+			const size_t rowEnd   = _cellStart[(size_t) y * _cellsX + maxX + 1];
 
-		return result;
+			for(size_t idx = rowBegin; idx < rowEnd; idx++)
+			{
+				func(_sortedSlots[idx], _sortedPos[idx]);
+			}
+		}
 	}
 }
@@ -1,11 +1,15 @@
 #pragma once
 
 #include "GpuCalculator.h"
+#include "SpatialGrid.h"
+#include "Export/INavSystemPublic.h"
+#include "Navigation/AgentStore.h"
 #include "Navigation/AgentSpatialInfo.h"
 #include "Navigation/NeighborInfo.h"
 
-#include "Util/ctpl_stl.h"
+#include "Util/TaskScheduler.h"
 
+#include <memory>
 #include <vector>
 
 namespace FusionCrowd
@@ -13,21 +17,69 @@ namespace FusionCrowd
 	class NeighborsSeeker
 	{
 	public:
-		using SearchRequest = AgentSpatialInfo;
-
 		struct SearchResult
 		{
 			size_t agentId;
 			std::vector<NeighborInfo> neighbors;
-			bool isOverlapped;
+			bool isOverlapped = false;
 		};
 
 	public:
 		NeighborsSeeker();
 
-		std::vector<SearchResult> FindNeighborsCpu(std::vector<SearchRequest> searchRequests);
+		void SetMode(NeighbourSearchMode mode) { _mode = mode; }
+		NeighbourSearchMode GetMode() const { return _mode; }
+
+		void SetScheduler(std::shared_ptr<TaskScheduler> scheduler) { _scheduler = scheduler; }
+
+		// Verlet lists: candidates are collected within R + skin and only refiltered
+		// until some agent moves further than skin / 2. Zero skin disables them.
+		void SetVerletSkin(float skin);
+		float GetVerletSkin() const { return _skin; }
+		// Has to be called when agents are added or removed
+		void InvalidateVerletLists();
+
+		const NeighbourSearchStats & GetStats() const { return _stats; }
+
+		// Agents are split into contiguous slot ranges processed by the scheduler,
+		// results[slot] is overwritten for every agent in the store.
+		// Grid is used only in HashedGrid mode.
+		void FindNeighborsCpu(const AgentStore & agents, const SpatialGrid & grid, std::vector<SearchResult> & results);
+
+	private:
+		void BuildCellLists(const AgentStore & agents);
+		bool IsVerletRebuildNeeded(const AgentStore & agents);
+
+		// Calls func(slot, pos) for every agent in cells overlapping the square around pos
+		template <typename Func>
+		void ForEachCandidate(const AgentStore & agents, const SpatialGrid & grid, DirectX::SimpleMath::Vector2 pos, float range, Func func) const;
+		template <typename Func>
+		void ScanGrid(const AgentStore & agents, const SpatialGrid & grid, DirectX::SimpleMath::Vector2 pos, float range, Func & func) const;
+		template <typename Func>
+		void ScanCellLists(DirectX::SimpleMath::Vector2 pos, float range, Func & func) const;
 
 	private:
-		ctpl::thread_pool _pool;
+		NeighbourSearchMode _mode = CountingSort;
+		NeighbourSearchStats _stats;
+
+		float _skin = 0.f;
+		bool _candidatesValid = false;
+		std::vector<std::vector<size_t>> _candidates;
+		std::vector<DirectX::SimpleMath::Vector2> _candidatesPos;
+		std::vector<float> _candidatesRange;
+
+		std::shared_ptr<TaskScheduler> _scheduler;
+
+		// Counting-sort cell lists, rebuilt every search:
+		// agents of cell c are _sortedSlots[_cellStart[c] .. _cellStart[c + 1])
+		DirectX::SimpleMath::Vector2 _origin;
+		float _cellSize = 1.f;
+		int _cellsX = 0;
+		int _cellsY = 0;
+
+		std::vector<size_t> _cellStart;
+		std::vector<size_t> _agentCell;
+		std::vector<size_t> _sortedSlots;
+		std::vector<DirectX::SimpleMath::Vector2> _sortedPos;
 	};
 }
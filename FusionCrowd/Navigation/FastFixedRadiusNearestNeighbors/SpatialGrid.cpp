@@ -0,0 +1,129 @@
+#include "SpatialGrid.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace DirectX::SimpleMath;
+
+namespace FusionCrowd
+{
+	const SpatialGrid::CellKey SpatialGrid::NO_CELL;
+
+	SpatialGrid::SpatialGrid()
+	{
+	}
+
+	void SpatialGrid::Update(const AgentStore & agents)
+	{
+		_movedCount = 0;
+
+		// Cell size follows the largest search radius. Small changes are absorbed,
+		// the grid is rebuilt only when searches would need more than 3x3 cells
+		// or cells become too coarse.
+		const float maxR = MaxSearchRadius(agents);
+		if(maxR > _cellSize || maxR < 0.5f * _cellSize)
+		{
+			Clear();
+			_cellSize = maxR;
+		}
+
+		const Vector2 * positions = agents.Positions();
+		for(size_t i = 0; i < agents.Size(); i++)
+		{
+			const size_t id = agents.IdAt(i);
+			const CellKey key = MakeKey(GetCell(positions[i]));
+
+			if(id >= _agentCells.size())
+				_agentCells.resize(id + 1, NO_CELL);
+
+			const CellKey oldKey = _agentCells[id];
+			if(oldKey == key)
+				continue;
+
+			if(oldKey != NO_CELL)
+				Erase(id, oldKey);
+
+			Insert(id, key);
+			_movedCount++;
+		}
+	}
+
+	void SpatialGrid::Remove(size_t agentId)
+	{
+		if(agentId >= _agentCells.size() || _agentCells[agentId] == NO_CELL)
+			return;
+
+		Erase(agentId, _agentCells[agentId]);
+		_agentCells[agentId] = NO_CELL;
+	}
+
+	void SpatialGrid::Clear()
+	{
+		_cells.clear();
+		std::fill(_agentCells.begin(), _agentCells.end(), NO_CELL);
+	}
+
+	SpatialGrid::Cell SpatialGrid::GetCell(Vector2 pos) const
+	{
+		return Cell {
+			(int) std::floor(pos.x / _cellSize),
+			(int) std::floor(pos.y / _cellSize)
+		};
+	}
+
+	const std::vector<size_t> * SpatialGrid::GetCellAgents(Cell cell) const
+	{
+		auto it = _cells.find(MakeKey(cell));
+		if(it == _cells.end())
+			return nullptr;
+
+		return &it->second;
+	}
+
+	SpatialGrid::CellKey SpatialGrid::MakeKey(Cell cell)
+	{
+		// Coordinates are biased so that NO_CELL maps to (INT_MAX, INT_MAX), which is never reached
+		const uint32_t x = (uint32_t) cell.x + 0x80000000u;
+		const uint32_t y = (uint32_t) cell.y + 0x80000000u;
+
+		return ((CellKey) x << 32) | (CellKey) y;
+	}
+
+	void SpatialGrid::Insert(size_t agentId, CellKey key)
+	{
+		_cells[key].push_back(agentId);
+		_agentCells[agentId] = key;
+	}
+
+	void SpatialGrid::Erase(size_t agentId, CellKey key)
+	{
+		auto it = _cells.find(key);
+		if(it == _cells.end())
+			return;
+
+		auto & ids = it->second;
+		auto pos = std::find(ids.begin(), ids.end(), agentId);
+		if(pos != ids.end())
+		{
+			*pos = ids.back();
+			ids.pop_back();
+		}
+
+		if(ids.empty())
+			_cells.erase(it);
+	}
+
+	float SpatialGrid::MaxSearchRadius(const AgentStore & agents)
+	{
+		float maxR = 0.f;
+		for(size_t i = 0; i < agents.Size(); i++)
+		{
+			const float R = agents.At(i).neighbourSearchShape->BoundingRadius();
+			if(R > maxR)
+				maxR = R;
+		}
+
+		// Degenerate shapes still need a valid cell size
+		return maxR > 0.f ? maxR : 1.f;
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "Math/Util.h"
+#include "Navigation/AgentStore.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace FusionCrowd
+{
+	// Persistent uniform grid over agent positions. Cell size is not smaller than
+	// the largest neighbour search radius, so any search touches at most 3x3 cells.
+	// Update only moves agents whose cell has changed since the previous call.
+	class SpatialGrid
+	{
+	public:
+		struct Cell
+		{
+			int x;
+			int y;
+		};
+
+		using CellKey = uint64_t;
+
+	public:
+		SpatialGrid();
+
+		void Update(const AgentStore & agents);
+		void Remove(size_t agentId);
+		void Clear();
+
+		inline float GetCellSize() const { return _cellSize; }
+		inline size_t GetMovedCount() const { return _movedCount; }
+
+		Cell GetCell(DirectX::SimpleMath::Vector2 pos) const;
+
+		// Agent ids in the cell, nullptr if the cell is empty
+		const std::vector<size_t> * GetCellAgents(Cell cell) const;
+
+		static CellKey MakeKey(Cell cell);
+		static float MaxSearchRadius(const AgentStore & agents);
+
+	private:
+		static const CellKey NO_CELL = UINT64_MAX;
+
+		void Insert(size_t agentId, CellKey key);
+		void Erase(size_t agentId, CellKey key);
+
+		float _cellSize = 0.f;
+		size_t _movedCount = 0;
+
+		std::unordered_map<CellKey, std::vector<size_t>> _cells;
+		std::vector<CellKey> _agentCells;
+	};
+}
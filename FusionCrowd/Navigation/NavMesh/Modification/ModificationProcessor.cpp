@@ -94,15 +94,7 @@ namespace FusionCrowd {
 		global_poly_size = _modification._global_polygon.size();
 		std::vector<unsigned int> nodes_ids = std::vector<unsigned int>(global_poly_size);
 		if (global_poly_size < 3) return 0;
-		for (int i = 0; i < global_poly_size; i++) {
-			NavMeshNode* node = _modification.GetGlobalPolygonNodeByVertexId(i);
-			if (node != nullptr) {
-				nodes_ids[i] = node->_id;
-			}
-			else {
-				nodes_ids[i] = NavMeshLocation::NO_NODE;
-			}
-		}
+		_modification._localizer->LocateBatch(_modification._global_polygon, nodes_ids);
 
 #pragma region start_pos_proccess
 		int start_pos = 0;
@@ -244,7 +244,9 @@ namespace FusionCrowd {
 		}
 
 		_spatial_query->Update();
-		_navmesh.IncVersion();
+		// Surviving nodes keep their polygons and portals, so only routes
+		// through deleted nodes have to be replanned
+		_navmesh.IncVersion(_nodes_ids_to_delete);
 
 		Clear();
 		return 0;
@@ -417,9 +417,23 @@ namespace FusionCrowd
 		return _version;
 	}
 
-	void NavMesh::IncVersion()
+	size_t NavMesh::GetNodeVersion(unsigned int id) const
+	{
+		if (id >= _nodeVersions.size())
+			return 0;
+
+		return _nodeVersions[id];
+	}
+
+	void NavMesh::IncVersion(const std::vector<size_t> & changedNodes)
 	{
 		_version++;
+		_nodeVersions.resize(nCount, 0);
+		for (size_t id : changedNodes)
+		{
+			if (id < _nodeVersions.size())
+				_nodeVersions[id] = _version;
+		}
 	}
 
 	size_t NavMesh::GetVertexCount() {
@@ -74,7 +74,9 @@ namespace FusionCrowd
 		const NMNodeGroup* getNodeGroup(const std::string& grpName) const;
 
 		size_t GetVersion() const;
-		void IncVersion();
+		// Version at which the node was last deleted or changed, 0 for untouched nodes
+		size_t GetNodeVersion(unsigned int id) const;
+		void IncVersion(const std::vector<size_t> & changedNodes);
 
 	public:
 		// INavMeshPublicAPI
@@ -110,5 +112,6 @@ namespace FusionCrowd
 
 	private:
 		size_t _version = 0;
+		std::vector<size_t> _nodeVersions;
 	};
 }
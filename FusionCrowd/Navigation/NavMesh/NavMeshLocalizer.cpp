@@ -4,6 +4,7 @@
 #include "TacticComponent/NavMesh/Path/PathPlanner.h"
 #include "TacticComponent/NavMesh/Path/PortalPath.h"
 
+#include <algorithm>
 #include <limits>
 #include <iostream>
 
@@ -89,6 +90,8 @@ namespace FusionCrowd
 		}
 
 		_nodeBBTree = std::make_unique<QuadTree>(nodeBoxes);
+
+		BuildBoundaryTree();
 	}
 
 	NavMeshLocalizer::~NavMeshLocalizer()
@@ -109,11 +112,10 @@ namespace FusionCrowd
 		float elevDiff = 1e6f;
 		unsigned int maxNode = NavMeshLocation::NO_NODE;
 
-		for(size_t nodeId : _nodeBBTree->GetContainingBBIds(p))
-		//for (size_t nodeId = 0; nodeId <_navMesh->getNodeCount(); nodeId++)
+		_nodeBBTree->ForEachContainingBBId(p, [&](size_t nodeId)
 		{
 			const NavMeshNode* node = _navMesh->GetNodeByID(nodeId);
-			if (node->deleted) continue;
+			if (node->deleted) return;
 			if (node->containsPoint(p))
 			{
 				float hDiff = fabs(node->getElevation(p) - tgtElev);
@@ -123,10 +125,61 @@ namespace FusionCrowd
 					elevDiff = hDiff;
 				}
 			}
-		}
+		});
 		return maxNode;
 	}
 
+	void NavMeshLocalizer::LocateBatch(Span<Vector2> points, MutableSpan<unsigned int> out)
+	{
+		const size_t count = std::min(points.size(), out.size());
+		if (count == 0)
+			return;
+
+		// Morton order puts nearby points next to each other, so the node found
+		// for the previous point is usually the right one or its neighbour
+		float minX = INFINITY, minY = INFINITY, maxX = -INFINITY, maxY = -INFINITY;
+		for (size_t i = 0; i < count; i++)
+		{
+			minX = std::min(minX, points[i].x);
+			minY = std::min(minY, points[i].y);
+			maxX = std::max(maxX, points[i].x);
+			maxY = std::max(maxY, points[i].y);
+		}
+
+		const float scaleX = maxX > minX ? 65535.f / (maxX - minX) : 0.f;
+		const float scaleY = maxY > minY ? 65535.f / (maxY - minY) : 0.f;
+
+		std::vector<std::pair<uint32_t, size_t>> order(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			const uint32_t x = (uint32_t)((points[i].x - minX) * scaleX);
+			const uint32_t y = (uint32_t)((points[i].y - minY) * scaleY);
+			order[i] = { Math::MortonCode(x, y), i };
+		}
+		std::sort(order.begin(), order.end());
+
+		auto locateRange = [&](size_t begin, size_t end)
+		{
+			unsigned int hint = NavMeshLocation::NO_NODE;
+			for (size_t i = begin; i < end; i++)
+			{
+				const size_t idx = order[i].second;
+				const unsigned int node = findNodeNear(points[idx], hint);
+				out[idx] = node;
+				if (node != NavMeshLocation::NO_NODE)
+					hint = node;
+			}
+		};
+
+		if (_scheduler == nullptr)
+		{
+			locateRange(0, count);
+			return;
+		}
+
+		_scheduler->ParallelFor(count, locateRange, MIN_BATCH_CHUNK);
+	}
+
 	unsigned int NavMeshLocalizer::findNodeInGroup(const Vector2& p, const std::string& grpName, bool searchAll) const
 	{
 		unsigned int node = NavMeshLocation::NO_NODE;
@@ -169,6 +222,7 @@ namespace FusionCrowd
 		for (unsigned int n = 0; n < nCount; ++n)
 		{
 			const NavMeshNode* nbr = node.getNeighbor(n);
+			if (nbr == nullptr || nbr->deleted) continue;
 			if (nbr->containsPoint(p))
 			{
 				return nbr->getID();
@@ -178,38 +232,117 @@ namespace FusionCrowd
 	}
 
 
-	DirectX::SimpleMath::Vector2 NavMeshLocalizer::GetClosestAvailablePoint(DirectX::SimpleMath::Vector2 p) {
-		if (findNodeBlind(p) != NavMeshLocation::NO_NODE)
+	unsigned int NavMeshLocalizer::findNodeNear(const Vector2& p, unsigned int lastNode) const
+	{
+		if (lastNode < _navMesh->getNodeCount())
 		{
+			const NavMeshNode& node = _navMesh->GetNodeByPos(lastNode);
+			if (!node.deleted)
+			{
+				if (node.containsPoint(p))
+				{
+					return lastNode;
+				}
+
+				const unsigned int nbr = testNeighbors(node, p);
+				if (nbr != NavMeshLocation::NO_NODE)
+				{
+					return nbr;
+				}
+			}
+		}
+
+		return findNodeBlind(p);
+	}
+
+	DirectX::SimpleMath::Vector2 NavMeshLocalizer::GetClosestAvailablePoint(DirectX::SimpleMath::Vector2 p, unsigned int & node, float stepLength)
+	{
+		const unsigned int found = findNodeNear(p, node);
+		if (found != NavMeshLocation::NO_NODE)
+		{
+			node = found;
 			return p;
 		}
 
-		float min_dist = INFINITY;
+		if (node >= _navMesh->getNodeCount() || _navMesh->GetNodeByPos(node).deleted)
+		{
+			Vector2 res;
+			if (!FindClosestBoundaryPoint(p, res, node))
+			{
+				throw 1;
+			}
+			return res;
+		}
+
+		// The point has just left the mesh, so the closest walkable point
+		// usually lies on the boundary of the last node or one of its neighbours
+		const NavMeshNode& last = _navMesh->GetNodeByPos(node);
 		Vector2 res;
-		auto* vertices = _navMesh->GetVertices();
-		for (int i = _navMesh->getNodeCount() - 1; i >= 0; i--)
+		float minDist = ClosestPointOnNode(last, p, res);
+
+		const size_t nCount = last.getNeighborCount();
+		for (size_t n = 0; n < nCount; ++n)
 		{
-			const auto & node = _navMesh->GetNodeByPos(i);
-			if (node.deleted)
-				continue;
+			const NavMeshNode* nbr = last.getNeighbor(n);
+			if (nbr == nullptr || nbr->deleted) continue;
 
-			const size_t vCount = node.getVertexCount();
-			for (size_t v = 0; v < vCount; v++)
+			Vector2 projection;
+			const float d = ClosestPointOnNode(*nbr, p, projection);
+			if (d < minDist)
 			{
-				Vector2 vertex1 = vertices[node.getVertexID(v)];
-				Vector2 vertex2 = vertices[(node.getVertexID(v) + 1) % vCount];
+				minDist = d;
+				res = projection;
+				node = nbr->getID();
+			}
+		}
 
-				auto projection = Math::projectOnSegment(vertex1, vertex2, p);
+		// The point was on the mesh one step ago, so the closest walkable point is no
+		// farther than the step. Otherwise it has crossed more nodes than the last one.
+		if (minDist > stepLength * stepLength)
+		{
+			Vector2 global;
+			unsigned int globalNode;
+			if (FindClosestBoundaryPoint(p, global, globalNode))
+			{
+				node = globalNode;
+				return global;
+			}
+		}
 
-				const float d = Vector2::DistanceSquared(p, projection);
-				if (d < min_dist)
-				{
-					min_dist = d;
-					res = projection;
-				}
+		return res;
+	}
+
+	float NavMeshLocalizer::ClosestPointOnNode(const NavMeshNode& node, const Vector2& p, Vector2& res) const
+	{
+		float minDist = INFINITY;
+		const Vector2* vertices = _navMesh->GetVertices();
+		const size_t vCount = node.getVertexCount();
+		for (size_t v = 0; v < vCount; v++)
+		{
+			const Vector2 vertex1 = vertices[node.getVertexID(v)];
+			const Vector2 vertex2 = vertices[node.getVertexID((v + 1) % vCount)];
+
+			const Vector2 projection = Math::projectOnSegment(vertex1, vertex2, p);
+			const float d = Vector2::DistanceSquared(p, projection);
+			if (d < minDist)
+			{
+				minDist = d;
+				res = projection;
 			}
 		}
-		if (min_dist == INFINITY)
+
+		return minDist;
+	}
+
+	DirectX::SimpleMath::Vector2 NavMeshLocalizer::GetClosestAvailablePoint(DirectX::SimpleMath::Vector2 p) {
+		if (findNodeBlind(p) != NavMeshLocation::NO_NODE)
+		{
+			return p;
+		}
+
+		Vector2 res;
+		unsigned int node;
+		if (!FindClosestBoundaryPoint(p, res, node))
 		{
 			throw 1;
 		}
@@ -217,11 +350,72 @@ namespace FusionCrowd
 		return res;
 	}
 
+	bool NavMeshLocalizer::FindClosestBoundaryPoint(const Vector2& p, Vector2& res, unsigned int& node) const
+	{
+		auto alive = [this](size_t nodeId) { return !_navMesh->GetNodeByPos((unsigned int)nodeId).deleted; };
+
+		float minDist = INFINITY;
+		size_t nodeId = NavMeshLocation::NO_NODE;
+		bool found = _edgeTree->FindClosest(p, alive, res, nodeId, minDist);
+		if (_addedEdgeTree != nullptr)
+		{
+			found = _addedEdgeTree->FindClosest(p, alive, res, nodeId, minDist) || found;
+		}
+
+		node = found ? (unsigned int)nodeId : NavMeshLocation::NO_NODE;
+		return found;
+	}
+
+	void NavMeshLocalizer::AddNodeSegments(const NavMeshNode& node, std::vector<SegmentTree::Segment>& segments) const
+	{
+		const size_t vCount = node.getVertexCount();
+		for (size_t v = 0; v < vCount; v++)
+		{
+			segments.push_back({
+				node._poly.getVertexByPos((int)v),
+				node._poly.getVertexByPos((int)((v + 1) % vCount)),
+				node.getID()
+			});
+		}
+	}
+
+	void NavMeshLocalizer::BuildBoundaryTree()
+	{
+		std::vector<SegmentTree::Segment> segments;
+		for (size_t nodeId = 0; nodeId < _navMesh->getNodeCount(); nodeId++)
+		{
+			const NavMeshNode& node = _navMesh->GetNodeByPos(nodeId);
+			if (node.deleted)
+				continue;
+
+			AddNodeSegments(node, segments);
+		}
+
+		_edgeTree = std::make_unique<SegmentTree>(std::move(segments));
+		_addedEdgeTree = nullptr;
+		_addedEdges.clear();
+	}
+
 	void NavMeshLocalizer::Update(std::vector<NavMeshNode*>& added_nodes, std::vector<size_t>& del_nodes) {
 		std::vector<QuadTree::Box> added_boxes = std::vector<QuadTree::Box>();
 		for (int i = 0; i < added_nodes.size(); i++) {
 			added_boxes.push_back({ added_nodes[i]->GetBB(), added_nodes[i]->_id });
 		}
 		_nodeBBTree->UpdateTree(added_boxes, del_nodes);
+
+		// Deleted nodes are skipped during queries, so only new edges have to be inserted
+		for (NavMeshNode* node : added_nodes)
+		{
+			AddNodeSegments(*node, _addedEdges);
+		}
+
+		if (4 * _addedEdges.size() > _edgeTree->Size())
+		{
+			BuildBoundaryTree();
+		}
+		else if (!added_nodes.empty())
+		{
+			_addedEdgeTree = std::make_unique<SegmentTree>(_addedEdges);
+		}
 	}
 }
@@ -5,6 +5,9 @@
 #include "Agent.h"
 #include "Math/Util.h"
 #include "Navigation/NavMesh/QuadTree.h"
+#include "Navigation/NavMesh/SegmentTree.h"
+#include "Util/Span.h"
+#include "Util/TaskScheduler.h"
 
 #include <set>
 
@@ -68,20 +71,46 @@ namespace FusionCrowd
 		std::shared_ptr<PathPlanner> getPlanner() { return _planner; }
 		void setPlanner(std::shared_ptr<PathPlanner> planner) { _planner = planner; }
 
+		// Used by batch queries, they run on the calling thread without it
+		void SetScheduler(std::shared_ptr<TaskScheduler> scheduler) { _scheduler = scheduler; }
+
 		const std::shared_ptr<NavMesh> getNavMesh() const { return _navMesh; }
 
 		std::vector<size_t> findNodesCrossingBB(BoundingBox bb);
 		unsigned int findNodeBlind(const DirectX::SimpleMath::Vector2& p, float tgtElev = 1e5f) const;
+		// Locates many points at once, out[i] receives the node of points[i] or NO_NODE
+		void LocateBatch(Span<DirectX::SimpleMath::Vector2> points, MutableSpan<unsigned int> out);
 		unsigned int findNodeInGroup(const DirectX::SimpleMath::Vector2& p, const std::string& grpName, bool searchAll) const;
 		unsigned int findNodeInRange(const DirectX::SimpleMath::Vector2& p, unsigned int start, unsigned int stop) const;
 		unsigned int testNeighbors(const NavMeshNode& node, const DirectX::SimpleMath::Vector2& p) const;
+		// Tries lastNode and its neighbours before the full QuadTree lookup
+		unsigned int findNodeNear(const DirectX::SimpleMath::Vector2& p, unsigned int lastNode) const;
 		DirectX::SimpleMath::Vector2 GetClosestAvailablePoint(DirectX::SimpleMath::Vector2 p);
+		// Same as above, node holds the last known node of the point and receives the new one.
+		// stepLength is how far the point has moved since it was on the mesh in that node.
+		DirectX::SimpleMath::Vector2 GetClosestAvailablePoint(DirectX::SimpleMath::Vector2 p, unsigned int & node, float stepLength);
+		// Closest point on edges of non deleted nodes and the node owning it
+		bool FindClosestBoundaryPoint(const DirectX::SimpleMath::Vector2& p, DirectX::SimpleMath::Vector2& res, unsigned int& node) const;
 		void Update(std::vector<NavMeshNode*>& added_nodes, std::vector<size_t>& del_nodes);
 
 	private:
+		void AddNodeSegments(const NavMeshNode& node, std::vector<SegmentTree::Segment>& segments) const;
+		void BuildBoundaryTree();
+		float ClosestPointOnNode(const NavMeshNode& node, const DirectX::SimpleMath::Vector2& p, DirectX::SimpleMath::Vector2& res) const;
+
 		std::shared_ptr<PathPlanner> _planner;
 		std::shared_ptr<NavMesh> _navMesh;
 		bool _trackAll;
 		std::unique_ptr<QuadTree> _nodeBBTree;
+
+		// Edges of nodes added by mesh modifications live in a small tree
+		// until it is merged into the main one
+		std::unique_ptr<SegmentTree> _edgeTree;
+		std::unique_ptr<SegmentTree> _addedEdgeTree;
+		std::vector<SegmentTree::Segment> _addedEdges;
+
+		// Smaller batches are not worth waking up workers
+		static const size_t MIN_BATCH_CHUNK = 256;
+		std::shared_ptr<TaskScheduler> _scheduler;
 	};
 }
@@ -28,6 +28,10 @@ namespace FusionCrowd
 	public:
 		std::vector<size_t> GetContainingBBIds(DirectX::SimpleMath::Vector2 point);
 		std::vector<size_t> GetIntersectingBBIds(BoundingBox box);
+
+		// Allocation free and thread safe version of GetContainingBBIds
+		template <typename Func>
+		void ForEachContainingBBId(DirectX::SimpleMath::Vector2 point, Func func) const;
 		void UpdateTree(std::vector<Box>& add_boxes, std::vector<size_t>& del_boxes);
 	private:
 		struct Node
@@ -67,4 +71,31 @@ namespace FusionCrowd
 
 		void MakeDepthWalk(std::vector<size_t>& depth_walk, size_t parent_pos, std::set<size_t>& visited);
 	};
+
+	template <typename Func>
+	void QuadTree::ForEachContainingBBId(DirectX::SimpleMath::Vector2 point, Func func) const
+	{
+		size_t currentId = _rootNode;
+
+		while(true)
+		{
+			const Node & current = _stored_nodes[currentId];
+			for(size_t idx = current.start; idx < current.start + current.len; idx++)
+			{
+				if(_stored_boxes[idx].bb.Contains(point.x, point.y))
+					func(_stored_boxes[idx].objectId);
+			}
+
+			if(current.LeafNode())
+				break;
+
+			if(point.x <= current.xmid)
+			{
+				currentId = point.y <= current.ymid ? current.topLeft() : current.bottomLeft();
+			} else
+			{
+				currentId = point.y <= current.ymid ? current.topRight() : current.bottomRight();
+			}
+		}
+	}
 }
@@ -0,0 +1,67 @@
+#include "SegmentTree.h"
+
+#include <algorithm>
+
+using namespace DirectX::SimpleMath;
+
+namespace FusionCrowd
+{
+	SegmentTree::SegmentTree(std::vector<Segment> segments, size_t leafSize)
+		: _segments(std::move(segments)), _leafSize(leafSize > 0 ? leafSize : 1)
+	{
+		if (_segments.empty())
+			return;
+
+		_nodes.reserve(2 * _segments.size() / _leafSize + 1);
+		BuildSubTree(0, _segments.size(), 0);
+	}
+
+	uint32_t SegmentTree::BuildSubTree(size_t begin, size_t end, size_t depth)
+	{
+		const uint32_t nodeId = (uint32_t)_nodes.size();
+		_nodes.emplace_back();
+
+		BoundingBox bb(INFINITY, INFINITY, -INFINITY, -INFINITY);
+		for (size_t i = begin; i < end; i++)
+		{
+			const Segment & s = _segments[i];
+			bb = bb.Union(BoundingBox(
+				std::min(s.p0.x, s.p1.x), std::min(s.p0.y, s.p1.y),
+				std::max(s.p0.x, s.p1.x), std::max(s.p0.y, s.p1.y)
+			));
+		}
+		_nodes[nodeId].bb = bb;
+
+		// Depth limit keeps the query stack bounded for degenerate inputs
+		if (end - begin <= _leafSize || depth >= MAX_DEPTH - 1)
+		{
+			_nodes[nodeId].start = (uint32_t)begin;
+			_nodes[nodeId].count = (uint32_t)(end - begin);
+			return nodeId;
+		}
+
+		// Median split of segment midpoints along the longer box side
+		const bool splitX = bb.xmax - bb.xmin >= bb.ymax - bb.ymin;
+		const size_t mid = begin + (end - begin) / 2;
+		std::nth_element(_segments.begin() + begin, _segments.begin() + mid, _segments.begin() + end,
+			[splitX](const Segment & a, const Segment & b)
+			{
+				return splitX ? a.p0.x + a.p1.x < b.p0.x + b.p1.x : a.p0.y + a.p1.y < b.p0.y + b.p1.y;
+			}
+		);
+
+		BuildSubTree(begin, mid, depth + 1);
+		const uint32_t right = BuildSubTree(mid, end, depth + 1);
+		_nodes[nodeId].right = right;
+
+		return nodeId;
+	}
+
+	float SegmentTree::DistSq(const BoundingBox & bb, Vector2 p)
+	{
+		const float dx = std::max(std::max(bb.xmin - p.x, 0.f), p.x - bb.xmax);
+		const float dy = std::max(std::max(bb.ymin - p.y, 0.f), p.y - bb.ymax);
+
+		return dx * dx + dy * dy;
+	}
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "Math/Util.h"
+#include "Math/BoundingBox.h"
+
+namespace FusionCrowd
+{
+	// Packed bounding volume hierarchy over line segments answering closest point queries.
+	// Nodes are stored in depth-first order: the left child follows its parent,
+	// the right child index is stored in the parent.
+	class SegmentTree
+	{
+	public:
+		struct Segment
+		{
+			Segment(): objectId(0) { }
+			Segment(DirectX::SimpleMath::Vector2 p0, DirectX::SimpleMath::Vector2 p1, size_t objectId)
+				: p0(p0), p1(p1), objectId(objectId) { }
+
+			DirectX::SimpleMath::Vector2 p0;
+			DirectX::SimpleMath::Vector2 p1;
+			size_t objectId;
+		};
+
+		SegmentTree(std::vector<Segment> segments, size_t leafSize = 4);
+
+		inline size_t Size() const { return _segments.size(); }
+
+		// Closest point on segments whose objectId passes accept, false if there is none.
+		// maxDistSq limits the search and receives the distance to the found point.
+		template<typename Accept>
+		bool FindClosest(DirectX::SimpleMath::Vector2 p, Accept accept, DirectX::SimpleMath::Vector2 & point, size_t & objectId, float & maxDistSq) const;
+
+	private:
+		struct Node
+		{
+			BoundingBox bb;
+			uint32_t start = 0;
+			uint32_t count = 0;
+			uint32_t right = 0;
+
+			inline bool LeafNode() const { return count > 0; }
+		};
+
+		static const size_t MAX_DEPTH = 64;
+
+		uint32_t BuildSubTree(size_t begin, size_t end, size_t depth);
+		static float DistSq(const BoundingBox & bb, DirectX::SimpleMath::Vector2 p);
+
+		std::vector<Segment> _segments;
+		std::vector<Node> _nodes;
+		const size_t _leafSize;
+	};
+
+	template<typename Accept>
+	bool SegmentTree::FindClosest(DirectX::SimpleMath::Vector2 p, Accept accept, DirectX::SimpleMath::Vector2 & point, size_t & objectId, float & maxDistSq) const
+	{
+		if (_nodes.empty())
+			return false;
+
+		bool found = false;
+		uint32_t stack[MAX_DEPTH + 1];
+		size_t top = 0;
+		stack[top++] = 0;
+
+		while (top > 0)
+		{
+			const Node & node = _nodes[stack[--top]];
+			if (DistSq(node.bb, p) >= maxDistSq)
+				continue;
+
+			if (node.LeafNode())
+			{
+				for (size_t i = node.start; i < node.start + node.count; i++)
+				{
+					const Segment & s = _segments[i];
+					if (!accept(s.objectId))
+						continue;
+
+					const DirectX::SimpleMath::Vector2 projection = Math::projectOnSegment(s.p0, s.p1, p);
+					const float d = DirectX::SimpleMath::Vector2::DistanceSquared(p, projection);
+					if (d < maxDistSq)
+					{
+						maxDistSq = d;
+						point = projection;
+						objectId = s.objectId;
+						found = true;
+					}
+				}
+				continue;
+			}
+
+			// Visit the closer child first, it is pushed last
+			const uint32_t left = (uint32_t)(&node - _nodes.data()) + 1;
+			const uint32_t right = node.right;
+			if (DistSq(_nodes[left].bb, p) < DistSq(_nodes[right].bb, p))
+			{
+				stack[top++] = right;
+				stack[top++] = left;
+			}
+			else
+			{
+				stack[top++] = left;
+				stack[top++] = right;
+			}
+		}
+
+		return found;
+	}
+}
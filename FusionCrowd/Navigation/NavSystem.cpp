@@ -6,6 +6,7 @@
 #include "TacticComponent/NavMesh/NavMeshComponent.h"
 
 #include "Navigation/AgentSpatialInfo.h"
+#include "Navigation/AgentStore.h"
 #include "Navigation/Obstacle.h"
 #include "Navigation/NavMesh/NavMesh.h"
 #include "Navigation/NavMesh/Modification/ModificationProcessor.h"
@@ -13,6 +14,7 @@
 #include "Navigation/NavMesh//Modification/EdgeObstacleReplaner.h"
 #include "Navigation/SpatialQuery/NavMeshSpatialQuery.h"
 #include "Navigation/FastFixedRadiusNearestNeighbors/NeighborsSeeker.h"
+#include "Navigation/FastFixedRadiusNearestNeighbors/SpatialGrid.h"
 
 
 #include <limits>
@@ -29,13 +31,19 @@ namespace FusionCrowd
 	class NavSystem::NavSystemImpl
 	{
 	public:
-		NavSystemImpl() { }
+		NavSystemImpl() : _scheduler(std::make_shared<TaskScheduler>())
+		{
+			_neighborsSeeker.SetScheduler(_scheduler);
+		}
 
 		void SetNavMesh(std::shared_ptr<NavMeshLocalizer> localizer)
 		{
 			_localizer = localizer;
 			_navMeshQuery = std::make_unique<NavMeshSpatialQuery>(localizer);
 			_navMesh = localizer->getNavMesh();
+			_localizer->SetScheduler(_scheduler);
+
+			BuildNodeObstacles();
 		}
 
 		void SetNavGraph(std::unique_ptr<NavGraph> navGraph)
@@ -55,27 +63,35 @@ namespace FusionCrowd
 
 		void AddAgent(AgentSpatialInfo spatialInfo)
 		{
-			if(_agentsInfo.find(spatialInfo.id) != _agentsInfo.end())
+			const AgentSpatialInfo::Type type = spatialInfo.type;
+			const size_t id = spatialInfo.id;
+			if(!_agents.Add(std::move(spatialInfo)))
 				return;
 
-			if(spatialInfo.type == AgentSpatialInfo::AGENT)
+			UpdateClosestObstacles(_agents.GetSlot(id));
+
+			_neighborsSeeker.InvalidateVerletLists();
+
+			if(type == AgentSpatialInfo::AGENT)
 				_numAgents++;
 			else
 				_numGroups++;
-
-			_agentsInfo[spatialInfo.id] = std::move(spatialInfo);
-			_agentsNeighbours[spatialInfo.id] = std::vector<NeighborInfo>();
 		}
 
 		void RemoveAgent(size_t id)
 		{
-			if(_agentsInfo.erase(id))
-			{
-				if (_agentsInfo[id].type == AgentSpatialInfo::AGENT)
-					_numAgents--;
-				else
-					_numGroups--;
-			}
+			if(!_agents.Contains(id))
+				return;
+
+			const AgentSpatialInfo::Type type = _agents.Get(id).type;
+			_agents.Remove(id);
+			_grid.Remove(id);
+			_neighborsSeeker.InvalidateVerletLists();
+
+			if (type == AgentSpatialInfo::AGENT)
+				_numAgents--;
+			else
+				_numGroups--;
 		}
 
 		void AddTrafficLights(size_t NavGraphsNodeId)
@@ -99,52 +115,233 @@ namespace FusionCrowd
 
 		AgentSpatialInfo & GetSpatialInfo(size_t agentId)
 		{
-			return _agentsInfo.at(agentId);
+			return _agents.Get(agentId);
+		}
+
+		size_t GetAgentCount() const
+		{
+			return _agents.Size();
+		}
+
+		size_t GetAgentIndex(size_t agentId) const
+		{
+			return _agents.GetSlot(agentId);
+		}
+
+		AgentSpatialInfo & GetSpatialInfoByIndex(size_t index)
+		{
+			return _agents.At(index);
+		}
+
+		const AgentStore & GetAgentStore() const
+		{
+			return _agents;
 		}
 
-		std::vector<NeighborInfo> GetNeighbours(size_t agentId) const
+		Span<NeighborInfo> GetNeighbours(size_t agentId) const
 		{
-			auto cache = _agentsNeighbours.find(agentId);
+			const size_t slot = _agents.GetSlot(agentId);
 
-			if(cache == _agentsNeighbours.end())
-				return std::vector<NeighborInfo>();
+			if(slot == AgentStore::NO_SLOT)
+				return Span<NeighborInfo>();
 
-			return cache->second;
+			return Span<NeighborInfo>(_agents.NeighboursAt(slot));
 		}
 
-		std::vector<Obstacle> GetClosestObstacles(size_t agentId)
+		Span<Obstacle> GetClosestObstacles(size_t agentId) const
 		{
-			std::vector<Obstacle> result;
-			AgentSpatialInfo & agent = _agentsInfo.at(agentId);
+			const size_t slot = _agents.GetSlot(agentId);
+
+			if(slot == AgentStore::NO_SLOT)
+				return Span<Obstacle>();
 
+			return Span<Obstacle>(_agents.ObstaclesAt(slot));
+		}
+
+		void UpdateClosestObstacles()
+		{
+			_scheduler->ParallelFor(_agents.Size(), [this](size_t begin, size_t end)
+			{
+				for (size_t slot = begin; slot < end; slot++)
+				{
+					UpdateClosestObstacles(slot);
+				}
+			}, UPDATE_GRAIN);
+		}
+
+		void UpdateClosestObstacles(size_t slot)
+		{
+			std::vector<Obstacle> & result = _agents.ObstaclesAt(slot);
+			result.clear();
+
+			const AgentSpatialInfo & agent = _agents.At(slot);
 			if ((agent.useNavMeshObstacles) && (_navMesh != NULL))
 			{
-				size_t nodeId = _localizer->getNodeId(agent.GetPos());
-				if (nodeId == NavMeshLocation::NO_NODE)
-					return result;
+				const Vector2 pos = _agents.Positions()[slot];
+				unsigned int & nodeId = _agents.NavNodeAt(slot);
+				nodeId = _localizer->findNodeNear(pos, nodeId);
+				if (nodeId == NavMeshLocation::NO_NODE || nodeId >= _nodeObstacles.size())
+					return;
+
+				const float range = _navMeshQuery->GetObstacleRange();
+				const float rangeSq = range * range;
+				for (size_t obstId : _nodeObstacles[nodeId])
+				{
+					const NavMeshObstacle & obst = _navMesh->GetObstacle(obstId);
+					if (obst.pointOutside(pos) && obst.distSqPoint(pos) < rangeSq)
+					{
+						result.push_back(obst);
+					}
+				}
+			}
+		}
 
-				for (size_t obstId : _navMeshQuery->ObstacleQuery(agent.GetPos()))
+#pragma region NodeObstacles
+		// Every agent inside a node is inside its bounding box, so obstacles intersecting
+		// the box grown by query range are a superset of what any agent there can see
+		void BuildNodeObstacles(size_t nodeId)
+		{
+			const NavMeshNode & node = _navMesh->GetNodeByPos(nodeId);
+			if (node.deleted)
+			{
+				_nodeObstacles[nodeId].clear();
+				return;
+			}
+
+			_nodeObstacles[nodeId] = _navMeshQuery->ObstacleCandidates(node.GetBB(), _navMeshQuery->GetObstacleRange());
+		}
+
+		void BuildNodeObstacles()
+		{
+			const size_t nodeCount = _navMesh->getNodeCount();
+
+			_nodeObstacles.clear();
+			_nodeObstacles.resize(nodeCount);
+			for (size_t nodeId = 0; nodeId < nodeCount; nodeId++)
+			{
+				BuildNodeObstacles(nodeId);
+			}
+		}
+
+		struct MeshSnapshot
+		{
+			size_t nodeCount;
+			std::vector<bool> deletedNodes;
+			std::vector<size_t> obstacleNodes;
+		};
+
+		MeshSnapshot TakeMeshSnapshot() const
+		{
+			MeshSnapshot snapshot;
+			snapshot.nodeCount = _navMesh->getNodeCount();
+			snapshot.deletedNodes.resize(snapshot.nodeCount);
+			for (size_t nodeId = 0; nodeId < snapshot.nodeCount; nodeId++)
+			{
+				snapshot.deletedNodes[nodeId] = _navMesh->GetNodeByPos(nodeId).deleted;
+			}
+
+			const size_t obstCount = _navMesh->getObstacleCount();
+			snapshot.obstacleNodes.resize(obstCount);
+			for (size_t obstId = 0; obstId < obstCount; obstId++)
+			{
+				snapshot.obstacleNodes[obstId] = _navMesh->GetObstacle(obstId).getNode()->getID();
+			}
+
+			return snapshot;
+		}
+
+		// Mesh modification appends new nodes and marks removed ones as deleted.
+		// Obstacles of deleted nodes are dropped and the rest are renumbered in order,
+		// so candidate lists of untouched nodes only need their ids remapped.
+		void UpdateNodeObstacles(const MeshSnapshot & before)
+		{
+			const size_t nodeCount = _navMesh->getNodeCount();
+			const size_t obstCount = _navMesh->getObstacleCount();
+
+			std::vector<size_t> changedNodes;
+			for (size_t nodeId = 0; nodeId < nodeCount; nodeId++)
+			{
+				const bool wasDeleted = nodeId < before.nodeCount && before.deletedNodes[nodeId];
+				if (nodeId >= before.nodeCount || (_navMesh->GetNodeByPos(nodeId).deleted && !wasDeleted))
+					changedNodes.push_back(nodeId);
+			}
+
+			if (changedNodes.empty())
+				return;
+
+			const size_t NO_OBSTACLE = std::numeric_limits<size_t>::max();
+			std::vector<size_t> remap(before.obstacleNodes.size(), NO_OBSTACLE);
+			size_t newId = 0;
+			for (size_t oldId = 0; oldId < before.obstacleNodes.size(); oldId++)
+			{
+				const size_t nodeId = before.obstacleNodes[oldId];
+				if (_navMesh->GetNodeByPos(nodeId).deleted)
+					continue;
+
+				if (newId >= obstCount || _navMesh->GetObstacle(newId).getNode()->getID() != nodeId)
 				{
-					result.push_back(_navMesh->GetObstacle(obstId));
+					// Renumbering does not follow the expected pattern, start over
+					BuildNodeObstacles();
+					return;
+				}
+
+				remap[oldId] = newId++;
+			}
+
+			_nodeObstacles.resize(nodeCount);
+			std::vector<bool> affected(nodeCount, false);
+			const float range = _navMeshQuery->GetObstacleRange();
+			for (size_t nodeId : changedNodes)
+			{
+				const BoundingBox & bb = _navMesh->GetNodeByPos(nodeId).GetBB();
+				affected[nodeId] = true;
+				for (size_t crossingId : _localizer->findNodesCrossingBB(
+					BoundingBox(bb.xmin - range, bb.ymin - range, bb.xmax + range, bb.ymax + range)))
+				{
+					if (crossingId < nodeCount)
+						affected[crossingId] = true;
 				}
 			}
-			return result;
+
+			for (size_t nodeId = 0; nodeId < nodeCount; nodeId++)
+			{
+				if (affected[nodeId])
+				{
+					BuildNodeObstacles(nodeId);
+					continue;
+				}
+
+				auto & candidates = _nodeObstacles[nodeId];
+				size_t kept = 0;
+				for (size_t oldId : candidates)
+				{
+					if (oldId < remap.size() && remap[oldId] != NO_OBSTACLE)
+						candidates[kept++] = remap[oldId];
+				}
+				candidates.resize(kept);
+			}
 		}
+#pragma endregion
 
 		void Update(float timeStep)
 		{
-			for (auto & info : _agentsInfo)
+			// Agents only read their own current state and write their own next slot
+			_scheduler->ParallelFor(_agents.Size(), [this, timeStep](size_t begin, size_t end)
 			{
-				AgentSpatialInfo & currentInfo = info.second;
+				for (size_t slot = begin; slot < end; slot++)
+				{
+					Vector2 newPos, newVel, newOrient;
+					UpdatePos(slot, timeStep, newPos, newVel);
+					UpdateOrient(slot, timeStep, newOrient);
 
-				Vector2 newPos, newVel, newOrient;
-				UpdatePos(currentInfo, timeStep, newPos, newVel);
-				UpdateOrient(currentInfo, timeStep, newOrient);
+					_agents.SetNext(slot, newPos, newVel, newOrient);
+				}
+			}, UPDATE_GRAIN);
 
-				currentInfo.Update(newPos, newVel, newOrient);
-			}
+			_agents.SwapBuffers();
 
 			UpdateNeighbours();
+			UpdateClosestObstacles();
 
 			for (auto& light : _trafficLights)
 			{
@@ -152,14 +349,19 @@ namespace FusionCrowd
 			}
 		}
 
-		void UpdatePos(AgentSpatialInfo & agent, float timeStep, Vector2 & updatedPos, Vector2 & updatedVel)
+		void UpdatePos(size_t slot, float timeStep, Vector2 & updatedPos, Vector2 & updatedVel)
 		{
-			const float delV = (agent.GetVel() - agent.velNew).Length();
+			const AgentSpatialInfo & agent = _agents.At(slot);
+			const Vector2 pos = _agents.Positions()[slot];
+			const Vector2 vel = _agents.Velocities()[slot];
+			const Vector2 velNew = _agents.NewVelocities()[slot];
+
+			const float delV = (vel - velNew).Length();
 
 			if (isnan(delV))
 			{
-				updatedVel = agent.GetVel();
-				updatedPos = agent.GetPos();
+				updatedVel = vel;
+				updatedPos = pos;
 
 				return;
 			}
@@ -167,23 +369,27 @@ namespace FusionCrowd
 			if (agent.inertiaEnabled && delV > agent.maxAccel * timeStep)
 			{
 				const float w = agent.maxAccel * timeStep / delV;
-				updatedVel = (1.f - w) * agent.GetVel() + w * agent.velNew;
+				updatedVel = (1.f - w) * vel + w * velNew;
 			}
 			else
 			{
-				updatedVel = agent.velNew;
+				updatedVel = velNew;
 			}
 
-			updatedPos = agent.GetPos() + agent.GetVel() * timeStep;
+			updatedPos = pos + vel * timeStep;
 			if (agent.useNavMeshObstacles)			{
-				updatedPos = _localizer->GetClosestAvailablePoint(updatedPos);
+				updatedPos = _localizer->GetClosestAvailablePoint(updatedPos, _agents.NavNodeAt(slot), vel.Length() * timeStep);
 			}
 			
 		}
 
-		void UpdateOrient(const AgentSpatialInfo & agent, float timeStep, Vector2 & newOrient)
+		void UpdateOrient(size_t slot, float timeStep, Vector2 & newOrient)
 		{
-			float speed = agent.GetVel().Length();
+			const AgentSpatialInfo & agent = _agents.At(slot);
+			const Vector2 vel = _agents.Velocities()[slot];
+			const Vector2 orient = _agents.Orientations()[slot];
+
+			float speed = vel.Length();
 			if(speed < Math::EPS)
 			{
 				newOrient = Vector2(0, 1);
@@ -192,7 +398,7 @@ namespace FusionCrowd
 
 			if(!agent.inertiaEnabled)
 			{
-				agent.GetVel().Normalize(newOrient);
+				vel.Normalize(newOrient);
 				return;
 			}
 
@@ -203,7 +409,7 @@ namespace FusionCrowd
 
 			const float speedThresh = agent.prefSpeed / 3.f;
 
-			Vector2 moveDir = agent.GetVel() / speed;
+			Vector2 moveDir = vel / speed;
 			if (speed >= speedThresh)
 			{
 				newOrient = moveDir;
@@ -211,7 +417,7 @@ namespace FusionCrowd
 			else
 			{
 				float frac = sqrtf(speed / speedThresh);
-				Vector2 prefDir = agent.prefVelocity.getPreferred();
+				Vector2 prefDir = _agents.PrefVelocities()[slot].getPreferred();
 				// prefDir *can* be zero if we've arrived at goal.  Only use it if it's non-zero.
 				if (prefDir.LengthSquared() > 0.000001f)
 				{
@@ -223,25 +429,25 @@ namespace FusionCrowd
 			// Now limit angular velocity.
 			const float MAX_ANGLE_CHANGE = timeStep * agent.maxAngVel;
 			float maxCt = cos(MAX_ANGLE_CHANGE);
-			float ct = newOrient.Dot(agent.GetOrient());
+			float ct = newOrient.Dot(orient);
 			if (ct < maxCt)
 			{
 				// changing direction at a rate greater than _maxAngVel
 				float maxSt = sin(MAX_ANGLE_CHANGE);
-				if (Math::det(agent.GetOrient(), newOrient) > 0.f)
+				if (Math::det(orient, newOrient) > 0.f)
 				{
 					// rotate _orient left
 					newOrient = Vector2(
-						maxCt * agent.GetOrient().x - maxSt * agent.GetOrient().y,
-						maxSt * agent.GetOrient().x + maxCt * agent.GetOrient().y
+						maxCt * orient.x - maxSt * orient.y,
+						maxSt * orient.x + maxCt * orient.y
 					);
 				}
 				else
 				{
 					// rotate _orient right
 					newOrient = Vector2(
-						maxCt * agent.GetOrient().x + maxSt * agent.GetOrient().y,
-						-maxSt * agent.GetOrient().x + maxCt * agent.GetOrient().y
+						maxCt * orient.x + maxSt * orient.y,
+						-maxSt * orient.x + maxCt * orient.y
 					);
 				}
 			}
@@ -249,30 +455,37 @@ namespace FusionCrowd
 
 		void UpdateNeighbours()
 		{
-			std::vector<NeighborsSeeker::SearchRequest> agentRequests;
+			if (_neighborsSeeker.GetMode() == HashedGrid)
+				_grid.Update(_agents);
 
-			for (auto & info : _agentsInfo)
+			_neighborsSeeker.FindNeighborsCpu(_agents, _grid, _searchResults);
+			for (size_t slot = 0; slot < _agents.Size(); slot++)
 			{
-				agentRequests.push_back(info.second);
-			}
-
-			for(const auto& p : _neighborsSeeker.FindNeighborsCpu(agentRequests))
-			{
-				_agentsNeighbours[p.agentId] = p.neighbors;
-				_agentsInfo[p.agentId].setOverlaping(p.isOverlapped);
+				// swap keeps both buffers allocated for the next search
+				std::swap(_agents.NeighboursAt(slot), _searchResults[slot].neighbors);
+				_agents.At(slot).setOverlaping(_searchResults[slot].isOverlapped);
 			}
 		}
 
 		void Init() {
+			_agents.SyncRadii();
 			UpdateNeighbours();
+			UpdateClosestObstacles();
 		}
 
 		float CutPolygonFromMesh(FCArray<NavMeshVetrex> & polygon) {
+			const MeshSnapshot before = TakeMeshSnapshot();
+
 			auto query = _navMeshQuery.get();
 			auto processor = ModificationProcessor(*_navMesh, _localizer, query);
 			PolygonPreprocessor pp(polygon);
 			auto res =  pp.performAll(processor);
 			//EdgeObstacleReplaner(*_navMesh, _localizer).Replan();
+
+			UpdateNodeObstacles(before);
+
+			// Obstacle copies may point to reallocated mesh obstacles
+			UpdateClosestObstacles();
 			return res;
 		}
 
@@ -281,17 +494,70 @@ namespace FusionCrowd
 			return _navMesh.get();
 		}
 
+		void SetNeighbourSearchMode(NeighbourSearchMode mode)
+		{
+			_neighborsSeeker.SetMode(mode);
+		}
+
+		NeighbourSearchMode GetNeighbourSearchMode() const
+		{
+			return _neighborsSeeker.GetMode();
+		}
+
+		void SetScheduler(std::shared_ptr<TaskScheduler> scheduler)
+		{
+			_scheduler = scheduler;
+			_neighborsSeeker.SetScheduler(scheduler);
+			if (_localizer != nullptr)
+				_localizer->SetScheduler(scheduler);
+		}
+
+		TaskScheduler & GetScheduler() const
+		{
+			return *_scheduler;
+		}
+
+		void SetThreadCount(size_t threadCount)
+		{
+			_scheduler->SetThreadCount(threadCount);
+		}
+
+		size_t GetThreadCount() const
+		{
+			return _scheduler->GetThreadCount();
+		}
+
+		void SetNeighbourSkin(float skin)
+		{
+			_neighborsSeeker.SetVerletSkin(skin);
+		}
+
+		float GetNeighbourSkin() const
+		{
+			return _neighborsSeeker.GetVerletSkin();
+		}
+
+		NeighbourSearchStats GetNeighbourSearchStats() const
+		{
+			return _neighborsSeeker.GetStats();
+		}
+
 	private:
-		std::unordered_map<size_t, std::vector<NeighborInfo>> _agentsNeighbours;
+		static const size_t UPDATE_GRAIN = 64;
+
 		std::unique_ptr<NavMeshSpatialQuery> _navMeshQuery;
 		std::shared_ptr<NavMesh> _navMesh;
 		std::shared_ptr<NavGraph> _navGraph;
 		std::shared_ptr<NavMeshLocalizer> _localizer;
 		std::map<size_t, TrafficLightsBunch*> _trafficLights;
 		std::set<size_t> _lightsIds;
+		std::vector<std::vector<size_t>> _nodeObstacles;
 
+		std::shared_ptr<TaskScheduler> _scheduler;
 		NeighborsSeeker _neighborsSeeker;
-		std::map<size_t, AgentSpatialInfo> _agentsInfo;
+		SpatialGrid _grid;
+		std::vector<NeighborsSeeker::SearchResult> _searchResults;
+		AgentStore _agents;
 		float _agentsSensitivityRadius = 6;
 		float _groupSensitivityRadius = 100;
 
@@ -330,12 +596,32 @@ namespace FusionCrowd
 		return pimpl->GetSpatialInfo(agentId);
 	}
 
-	std::vector<NeighborInfo> NavSystem::GetNeighbours(size_t agentId) const
+	size_t NavSystem::GetAgentCount() const
+	{
+		return pimpl->GetAgentCount();
+	}
+
+	size_t NavSystem::GetAgentIndex(size_t agentId) const
+	{
+		return pimpl->GetAgentIndex(agentId);
+	}
+
+	AgentSpatialInfo & NavSystem::GetSpatialInfoByIndex(size_t index)
+	{
+		return pimpl->GetSpatialInfoByIndex(index);
+	}
+
+	const AgentStore & NavSystem::GetAgentStore() const
+	{
+		return pimpl->GetAgentStore();
+	}
+
+	Span<NeighborInfo> NavSystem::GetNeighbours(size_t agentId) const
 	{
 		return pimpl->GetNeighbours(agentId);
 	}
 
-	std::vector<Obstacle> NavSystem::GetClosestObstacles(size_t agentId)
+	Span<Obstacle> NavSystem::GetClosestObstacles(size_t agentId) const
 	{
 		return pimpl->GetClosestObstacles(agentId);
 	}
@@ -345,6 +631,16 @@ namespace FusionCrowd
 		pimpl->Update(timeStep);
 	}
 
+	void NavSystem::SetScheduler(std::shared_ptr<TaskScheduler> scheduler)
+	{
+		pimpl->SetScheduler(scheduler);
+	}
+
+	TaskScheduler & NavSystem::GetScheduler() const
+	{
+		return pimpl->GetScheduler();
+	}
+
 	void NavSystem::Init() {
 		pimpl->Init();
 	}
@@ -359,6 +655,41 @@ namespace FusionCrowd
 		return pimpl->CutPolygonFromMesh(polygon);
 	}
 
+	void NavSystem::SetNeighbourSearchMode(NeighbourSearchMode mode)
+	{
+		pimpl->SetNeighbourSearchMode(mode);
+	}
+
+	NeighbourSearchMode NavSystem::GetNeighbourSearchMode() const
+	{
+		return pimpl->GetNeighbourSearchMode();
+	}
+
+	void NavSystem::SetThreadCount(size_t threadCount)
+	{
+		pimpl->SetThreadCount(threadCount);
+	}
+
+	size_t NavSystem::GetThreadCount() const
+	{
+		return pimpl->GetThreadCount();
+	}
+
+	void NavSystem::SetNeighbourSkin(float skin)
+	{
+		pimpl->SetNeighbourSkin(skin);
+	}
+
+	float NavSystem::GetNeighbourSkin() const
+	{
+		return pimpl->GetNeighbourSkin();
+	}
+
+	NeighbourSearchStats NavSystem::GetNeighbourSearchStats() const
+	{
+		return pimpl->GetNeighbourSearchStats();
+	}
+
 	void NavSystem::SetNavMesh(std::shared_ptr<NavMeshLocalizer> localizer)
 	{
 		pimpl->SetNavMesh(localizer);
@@ -13,9 +13,12 @@
 #include "Navigation/NavGraph/NavGraph.h"
 #include "Navigation/NeighborInfo.h"
 #include "Navigation/AgentSpatialInfo.h"
+#include "Navigation/AgentStore.h"
 #include "Navigation/TrafficLightsBunch.h"
 
 #include "Util/spimpl.h"
+#include "Util/Span.h"
+#include "Util/TaskScheduler.h"
 
 namespace FusionCrowd
 {
@@ -41,17 +44,39 @@ namespace FusionCrowd
 
 		AgentSpatialInfo & GetSpatialInfo(size_t agentId);
 
-		std::vector<NeighborInfo> GetNeighbours(size_t agentId) const;
-		std::vector<Obstacle> GetClosestObstacles(size_t agentId);
+		// Index-based access to dense agent storage, index is in [0, GetAgentCount()).
+		// Indices are not stable between AddAgent/RemoveAgent calls.
+		size_t GetAgentCount() const;
+		size_t GetAgentIndex(size_t agentId) const;
+		AgentSpatialInfo & GetSpatialInfoByIndex(size_t index);
+		const AgentStore & GetAgentStore() const;
+
+		// Views into NavSystem buffers, valid until the next Update, AddAgent or RemoveAgent
+		Span<NeighborInfo> GetNeighbours(size_t agentId) const;
+		Span<Obstacle> GetClosestObstacles(size_t agentId) const;
 
 		void Update(float timeStep);
 
+		// Scheduler shared with the components, NavSystem starts with a single-threaded one
+		void SetScheduler(std::shared_ptr<TaskScheduler> scheduler);
+		TaskScheduler & GetScheduler() const;
+
 	public:
 		// INavSystemPublic
 		INavMeshPublic* GetPublicNavMesh() const;
 
 		// Do we really need this method here?
 		float CutPolygonFromMesh(FCArray<NavMeshVetrex> & polygon);
+
+		void SetNeighbourSearchMode(NeighbourSearchMode mode);
+		NeighbourSearchMode GetNeighbourSearchMode() const;
+
+		void SetThreadCount(size_t threadCount);
+		size_t GetThreadCount() const;
+
+		void SetNeighbourSkin(float skin);
+		float GetNeighbourSkin() const;
+		NeighbourSearchStats GetNeighbourSearchStats() const;
 	private:
 		class NavSystemImpl;
 
@@ -10,6 +10,6 @@ namespace FusionCrowd
 			radius(agent.radius),
 			inertiaEnabled(agent.inertiaEnabled),
 			collisionsLevel(agent.collisionsLevel),
-			prefVel(agent.prefVelocity.getPreferredVel())
+			prefVel(agent.GetPrefVelocity().getPreferredVel())
 	{}
 }
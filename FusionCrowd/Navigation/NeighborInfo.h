@@ -8,18 +8,19 @@ namespace FusionCrowd
 {
 	struct NeighborInfo
 	{
-		size_t id;
+		size_t id = 0;
 
 		DirectX::SimpleMath::Vector2 pos;
 		DirectX::SimpleMath::Vector2 orient;
 		DirectX::SimpleMath::Vector2 vel;
 		DirectX::SimpleMath::Vector2 prefVel;
 
-		float radius;
+		float radius = 0.f;
 
-		bool inertiaEnabled;
-		AgentSpatialInfo::Type collisionsLevel;
+		bool inertiaEnabled = false;
+		AgentSpatialInfo::Type collisionsLevel = 0;
 
+		NeighborInfo() = default;
 		NeighborInfo(const AgentSpatialInfo& agent);
 
 		/*
@@ -1,5 +1,7 @@
 #include "NavMeshSpatialQuery.h"
 
+#include <algorithm>
+
 using namespace DirectX::SimpleMath;
 
 namespace FusionCrowd
@@ -67,8 +69,17 @@ namespace FusionCrowd
 
 	std::vector<size_t> NavMeshSpatialQuery::ObstacleQuery(Vector2 pt) const
 	{
-		float range = 3.2f;
-		return ObstacleQuery(pt, range);
+		return ObstacleQuery(pt, _obstacleRange);
+	}
+
+	std::vector<size_t> NavMeshSpatialQuery::ObstacleCandidates(const BoundingBox & bb, float range) const
+	{
+		auto result = _obstacleBBTree->GetIntersectingBBIds(
+			BoundingBox(bb.xmin - range, bb.ymin - range, bb.xmax + range, bb.ymax + range)
+		);
+		std::sort(result.begin(), result.end());
+
+		return result;
 	}
 
 	std::vector<size_t> NavMeshSpatialQuery::ObstacleQuery(Vector2 pt, float range) const
@@ -19,6 +19,11 @@ namespace FusionCrowd
 
 		std::vector<size_t> ObstacleQuery(DirectX::SimpleMath::Vector2 pt) const;
 		std::vector<size_t> ObstacleQuery(DirectX::SimpleMath::Vector2 pt, float rangeSq) const;
+
+		// Sorted ids of obstacles which may be within range of some point of bb
+		std::vector<size_t> ObstacleCandidates(const BoundingBox & bb, float range) const;
+		inline float GetObstacleRange() const { return _obstacleRange; }
+
 		DirectX::SimpleMath::Vector2 GetClosiestObstacle(BoundingBox bb);
 		bool QueryVisibility(
 			const DirectX::SimpleMath::Vector2& q1,
@@ -30,6 +35,7 @@ namespace FusionCrowd
 
 		std::unique_ptr<QuadTree> _obstacleBBTree;
 		std::shared_ptr<NavMeshLocalizer> _localizer;
+		float _obstacleRange = 3.2f;
 	};
 }
 
@@ -1,6 +1,7 @@
 #include "GCFComponent.h"
 
 #include "Math/geomQuery.h"
+#include "OperationComponent/ParallelAgents.h"
 
 #include <algorithm>
 
@@ -66,18 +67,16 @@ namespace FusionCrowd
 		void GCFComponent::Update(float timeStep)
 		{
 			_timeStep = timeStep;
-			for(auto & pair : _agents)
+			// Ellipses of all agents have to be updated before any of them is read
+			ParallelForAgents(*_navSystem, _agents, [this](AgentSpatialInfo & info, AgentParamentrs & params)
 			{
-				auto & info = _navSystem->GetSpatialInfo(pair.first);
 				UpdateEllipse(info);
-			}
+			});
 
-			for(auto & pair : _agents)
+			ParallelForAgents(*_navSystem, _agents, [this](AgentSpatialInfo & info, AgentParamentrs & params)
 			{
-				auto & info = _navSystem->GetSpatialInfo(pair.first);
-
 				ComputeNewVelocity(info);
-			}
+			});
 		}
 
 		void GCFComponent::AddAgent(size_t agentId)
@@ -105,21 +104,21 @@ namespace FusionCrowd
 			const float SPEED = agentInfo.GetVel().Length();
 			if (SPEED > 0.0001f) {
 				// No obstacle force if basically stationary
-				for (Obstacle & obst : _navSystem->GetClosestObstacles(agentInfo.id))
+				for (const Obstacle & obst : _navSystem->GetClosestObstacles(agentInfo.id))
 				{
 					force += ObstacleForce(agentInfo, obst);
 				}
 			}
 
 			// We're assuming unit mass
-			agentInfo.velNew = agentInfo.GetVel() + force * _timeStep;
+			agentInfo.SetVelNew(agentInfo.GetVel() + force * _timeStep);
 		}
 
 		void GCFComponent::UpdateEllipse(const AgentSpatialInfo & agentInfo)
 		{
 			float speed = agentInfo.GetVel().Length();
 
-			AgentParamentrs & agentParams = _agents[agentInfo.id];
+			AgentParamentrs & agentParams = _agents.at(agentInfo.id);
 			// update ellipse
 			agentParams._ellipse.SetCenter(agentInfo.GetPos());
 			agentParams._ellipse.SetOrientation(agentInfo.GetOrient());
@@ -131,7 +130,7 @@ namespace FusionCrowd
 
 		Vector2 GCFComponent::DriveForce(const AgentSpatialInfo & agentInfo) const
 		{
-			return (agentInfo.prefVelocity.getPreferredVel() - agentInfo.GetVel()) / _reactionTime;
+			return (agentInfo.GetPrefVelocity().getPreferredVel() - agentInfo.GetVel()) / _reactionTime;
 		}
 
 		int GCFComponent::GetRepulsionParameters(
@@ -139,14 +138,21 @@ namespace FusionCrowd
 			float& effDist, DirectX::SimpleMath::Vector2& forceDir,
 			float& K_ij, float& response, float& velScale, float& magnitude) const
 		{
-			const float PREF_SPEED = agent.prefVelocity.getPreferredVel().Length();
+			const float PREF_SPEED = agent.GetPrefVelocity().getPreferredVel().Length();
 
 			const AgentParamentrs & agentParams = _agents.at(agent.id);
 			const AgentParamentrs & otherParams = _agents.at(other.id);
 
 			forceDir = agentParams._ellipse.ellipseCenterDisplace(otherParams._ellipse);
 			float centerDist = forceDir.Length();
-			float dca = agentParams._ellipse.DistanceOfClosestApproach(otherParams._ellipse);
+
+			// Even bounding circles are too far apart to give force
+			const float gap = centerDist - agentParams._ellipse.GetLargerAxis() - otherParams._ellipse.GetLargerAxis();
+			if (gap >= _maxAgentDist) {
+				return 1;
+			}
+
+			float dca = DistanceOfClosestApproach(agentParams._ellipse, otherParams._ellipse, gap);
 			effDist = centerDist - dca;
 
 			float dist = forceDir.Length();
@@ -184,7 +190,20 @@ namespace FusionCrowd
 			return 0;
 		}
 
-		Vector2 GCFComponent::ObstacleForce(const AgentSpatialInfo & agent, Obstacle & obst) const
+		float GCFComponent::DistanceOfClosestApproach(const AgentShape::Ellipse & agent, const AgentShape::Ellipse & other, float gap) const
+		{
+			const float maxError =
+				(agent.GetLargerAxis() - agent.GetSmallerAxis()) + (other.GetLargerAxis() - other.GetSmallerAxis());
+
+			// gap is a lower bound of the effective distance
+			if (maxError <= _accuracy.absoluteError || maxError <= _accuracy.relativeError * gap) {
+				return agent.ApproxDistanceOfClosestApproach(other);
+			}
+
+			return agent.DistanceOfClosestApproach(other);
+		}
+
+		Vector2 GCFComponent::ObstacleForce(const AgentSpatialInfo & agent, const Obstacle & obst) const
 		{
 			Vector2 force(0.f, 0.f);
 
@@ -223,7 +242,7 @@ namespace FusionCrowd
 			//// No force if the point lies inside the ellipse
 			if (Bij > 0.f) return force;
 
-			const float PREF_SPEED = agent.prefVelocity.getPreferredVel().Length();
+			const float PREF_SPEED = agent.GetPrefVelocity().getPreferredVel().Length();
 			force = dir * Bij * PREF_SPEED;
 
 			return force;
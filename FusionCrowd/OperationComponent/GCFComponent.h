@@ -42,6 +42,17 @@ namespace FusionCrowd
 
 		};
 
+		// When the approximate ellipse distance of closest approach may be used instead of
+		// the exact one. Its error is bounded by the axis differences of both ellipses,
+		// both limits at 0 leave the approximation to circles only.
+		struct DistanceAccuracy
+		{
+			// Largest error, in metres
+			float absoluteError = 0.01f;
+			// Largest error relative to the effective distance between ellipses
+			float relativeError = 0.05f;
+		};
+
 		class GCFComponent : public IOperationComponent
 		{
 		public:
@@ -62,10 +73,15 @@ namespace FusionCrowd
 			int GetRepulsionParameters(const AgentSpatialInfo & agent, const NeighborInfo & other,
 				float& effDist, DirectX::SimpleMath::Vector2& forceDir,
 				float& K_ij, float& response, float& velScale, float& magnitude) const;
-			DirectX::SimpleMath::Vector2 ObstacleForce(const AgentSpatialInfo & agent, Obstacle & obst) const;
+			DirectX::SimpleMath::Vector2 ObstacleForce(const AgentSpatialInfo & agent, const Obstacle & obst) const;
 			float ComputeDistanceResponse(float effDist) const;
 
+			void SetDistanceAccuracy(const DistanceAccuracy & accuracy) { _accuracy = accuracy; }
+			const DistanceAccuracy & GetDistanceAccuracy() const { return _accuracy; }
+
 		private:
+			float DistanceOfClosestApproach(const AgentShape::Ellipse & agent, const AgentShape::Ellipse & other, float gap) const;
+
 			std::shared_ptr<NavSystem> _navSystem;
 			std::map<size_t, AgentParamentrs> _agents;
 			float _timeStep;
@@ -76,6 +92,8 @@ namespace FusionCrowd
 			float _maxAgentForse;
 			float _agentInterpWidth;
 			bool _speedColor;
+
+			DistanceAccuracy _accuracy;
 		};
 	}
 }
@@ -0,0 +1,326 @@
+#include "HelbingForceKernel.h"
+
+#include "Math/Util.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <immintrin.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define FC_TARGET_AVX2
+#else
+#define FC_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+using namespace DirectX::SimpleMath;
+
+namespace FusionCrowd
+{
+	namespace Helbing
+	{
+		namespace
+		{
+			const float MAX_FORCE = 1e15f;
+
+			// expf argument range where float result is finite and normal
+			const float EXP_HI = 88.0f;
+			const float EXP_LO = -87.0f;
+
+#pragma region Scalar
+			Vector2 PairForce(const ForceParams & params, Vector2 pos, Vector2 vel, float radius,
+				Vector2 otherPos, Vector2 otherVel, float otherRadius)
+			{
+				Vector2 normal_ij = pos - otherPos;
+				const float distance_ij = normal_ij.Length();
+				normal_ij.Normalize();
+
+				const float Radii_ij = radius + otherRadius;
+
+				float mag = params.agentScale * expf((Radii_ij - distance_ij) / params.forceDistance);
+				if (mag >= MAX_FORCE) {
+					mag = MAX_FORCE;
+				}
+				Vector2 force(normal_ij * mag);
+
+				if (distance_ij < Radii_ij) {
+					const Vector2 tangent_ij(normal_ij.y, -normal_ij.x);
+
+					const Vector2 f_pushing = normal_ij * (params.bodyForce * (Radii_ij - distance_ij));
+					const Vector2 f_friction = tangent_ij * (params.friction * (Radii_ij - distance_ij)) * fabs((otherVel - vel).Dot(tangent_ij));
+					force += f_pushing + f_friction;
+				}
+				return force;
+			}
+
+			Vector2 SumScalar(const ForceParams & params, Vector2 pos, Vector2 vel, float radius,
+				const NeighborArrays & n, size_t begin)
+			{
+				Vector2 force(0.f, 0.f);
+				for (size_t i = begin; i < n.count; i++)
+				{
+					force += PairForce(params, pos, vel, radius,
+						Vector2(n.posX[i], n.posY[i]), Vector2(n.velX[i], n.velY[i]), n.radius[i]);
+				}
+				return force;
+			}
+#pragma endregion
+
+#pragma region Sse
+			// Cephes-style exp: 2^n * p(r), relative error around 2e-7
+			inline __m128 Exp(__m128 x)
+			{
+				x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(EXP_LO)), _mm_set1_ps(EXP_HI));
+
+				__m128 fx = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(1.44269504088896341f)), _mm_set1_ps(0.5f));
+				// floor without SSE4.1
+				__m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(fx));
+				fx = _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, fx), _mm_set1_ps(1.f)));
+
+				x = _mm_sub_ps(x, _mm_mul_ps(fx, _mm_set1_ps(0.693359375f)));
+				x = _mm_sub_ps(x, _mm_mul_ps(fx, _mm_set1_ps(-2.12194440e-4f)));
+
+				__m128 y = _mm_set1_ps(1.9875691500e-4f);
+				y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(1.3981999507e-3f));
+				y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(8.3334519073e-3f));
+				y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(4.1665795894e-2f));
+				y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(1.6666665459e-1f));
+				y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(5.0000001201e-1f));
+				y = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(y, x), x), _mm_add_ps(x, _mm_set1_ps(1.f)));
+
+				const __m128i n = _mm_slli_epi32(_mm_add_epi32(_mm_cvttps_epi32(fx), _mm_set1_epi32(127)), 23);
+				return _mm_mul_ps(y, _mm_castsi128_ps(n));
+			}
+
+			inline float HorizontalSum(__m128 v)
+			{
+				__m128 shuf = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+				__m128 sums = _mm_add_ps(v, shuf);
+				shuf = _mm_movehl_ps(shuf, sums);
+				return _mm_cvtss_f32(_mm_add_ss(sums, shuf));
+			}
+
+			// Adds forces of neighbours [begin, begin + 4k) to fx, fy, returns the first unprocessed index
+			size_t SumSse(const ForceParams & params, Vector2 pos, Vector2 vel, float radius,
+				const NeighborArrays & n, size_t begin, float & outX, float & outY)
+			{
+				const __m128 px = _mm_set1_ps(pos.x);
+				const __m128 py = _mm_set1_ps(pos.y);
+				const __m128 vx = _mm_set1_ps(vel.x);
+				const __m128 vy = _mm_set1_ps(vel.y);
+				const __m128 r  = _mm_set1_ps(radius);
+
+				const __m128 zero    = _mm_setzero_ps();
+				const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+				const __m128 scale   = _mm_set1_ps(params.agentScale);
+				const __m128 invD    = _mm_set1_ps(1.f / params.forceDistance);
+				const __m128 body    = _mm_set1_ps(params.bodyForce);
+				const __m128 fric    = _mm_set1_ps(params.friction);
+				const __m128 maxF    = _mm_set1_ps(MAX_FORCE);
+
+				__m128 sumX = zero;
+				__m128 sumY = zero;
+
+				size_t i = begin;
+				for (; i + 4 <= n.count; i += 4)
+				{
+					const __m128 dx = _mm_sub_ps(px, _mm_loadu_ps(n.posX + i));
+					const __m128 dy = _mm_sub_ps(py, _mm_loadu_ps(n.posY + i));
+					const __m128 dist = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)));
+
+					// Coincident agents have zero normal, as Vector2::Normalize leaves it
+					const __m128 inv = _mm_and_ps(_mm_cmpgt_ps(dist, zero), _mm_div_ps(_mm_set1_ps(1.f), dist));
+					const __m128 nx = _mm_mul_ps(dx, inv);
+					const __m128 ny = _mm_mul_ps(dy, inv);
+
+					const __m128 radii = _mm_add_ps(r, _mm_loadu_ps(n.radius + i));
+					const __m128 pen = _mm_sub_ps(radii, dist);
+
+					const __m128 mag = _mm_min_ps(_mm_mul_ps(scale, Exp(_mm_mul_ps(pen, invD))), maxF);
+					__m128 fx = _mm_mul_ps(nx, mag);
+					__m128 fy = _mm_mul_ps(ny, mag);
+
+					// Contact forces, tangent is (ny, -nx)
+					const __m128 contact = _mm_cmplt_ps(dist, radii);
+					const __m128 rvx = _mm_sub_ps(_mm_loadu_ps(n.velX + i), vx);
+					const __m128 rvy = _mm_sub_ps(_mm_loadu_ps(n.velY + i), vy);
+					const __m128 tDot = _mm_and_ps(absMask, _mm_sub_ps(_mm_mul_ps(rvx, ny), _mm_mul_ps(rvy, nx)));
+
+					const __m128 push = _mm_mul_ps(body, pen);
+					const __m128 slide = _mm_mul_ps(_mm_mul_ps(fric, pen), tDot);
+
+					fx = _mm_add_ps(fx, _mm_and_ps(contact, _mm_add_ps(_mm_mul_ps(nx, push), _mm_mul_ps(ny, slide))));
+					fy = _mm_add_ps(fy, _mm_and_ps(contact, _mm_sub_ps(_mm_mul_ps(ny, push), _mm_mul_ps(nx, slide))));
+
+					sumX = _mm_add_ps(sumX, fx);
+					sumY = _mm_add_ps(sumY, fy);
+				}
+
+				outX += HorizontalSum(sumX);
+				outY += HorizontalSum(sumY);
+				return i;
+			}
+#pragma endregion
+
+#pragma region Avx2
+			FC_TARGET_AVX2 inline __m256 Exp(__m256 x)
+			{
+				x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(EXP_LO)), _mm256_set1_ps(EXP_HI));
+
+				__m256 fx = _mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(1.44269504088896341f)), _mm256_set1_ps(0.5f));
+				fx = _mm256_floor_ps(fx);
+
+				x = _mm256_sub_ps(x, _mm256_mul_ps(fx, _mm256_set1_ps(0.693359375f)));
+				x = _mm256_sub_ps(x, _mm256_mul_ps(fx, _mm256_set1_ps(-2.12194440e-4f)));
+
+				__m256 y = _mm256_set1_ps(1.9875691500e-4f);
+				y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(1.3981999507e-3f));
+				y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(8.3334519073e-3f));
+				y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(4.1665795894e-2f));
+				y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(1.6666665459e-1f));
+				y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(5.0000001201e-1f));
+				y = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(y, x), x), _mm256_add_ps(x, _mm256_set1_ps(1.f)));
+
+				const __m256i n = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvttps_epi32(fx), _mm256_set1_epi32(127)), 23);
+				return _mm256_mul_ps(y, _mm256_castsi256_ps(n));
+			}
+
+			FC_TARGET_AVX2 inline float HorizontalSum(__m256 v)
+			{
+				const __m128 lo = _mm256_castps256_ps128(v);
+				const __m128 hi = _mm256_extractf128_ps(v, 1);
+				return HorizontalSum(_mm_add_ps(lo, hi));
+			}
+
+			FC_TARGET_AVX2 size_t SumAvx2(const ForceParams & params, Vector2 pos, Vector2 vel, float radius,
+				const NeighborArrays & n, size_t begin, float & outX, float & outY)
+			{
+				const __m256 px = _mm256_set1_ps(pos.x);
+				const __m256 py = _mm256_set1_ps(pos.y);
+				const __m256 vx = _mm256_set1_ps(vel.x);
+				const __m256 vy = _mm256_set1_ps(vel.y);
+				const __m256 r  = _mm256_set1_ps(radius);
+
+				const __m256 zero    = _mm256_setzero_ps();
+				const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+				const __m256 scale   = _mm256_set1_ps(params.agentScale);
+				const __m256 invD    = _mm256_set1_ps(1.f / params.forceDistance);
+				const __m256 body    = _mm256_set1_ps(params.bodyForce);
+				const __m256 fric    = _mm256_set1_ps(params.friction);
+				const __m256 maxF    = _mm256_set1_ps(MAX_FORCE);
+
+				__m256 sumX = zero;
+				__m256 sumY = zero;
+
+				size_t i = begin;
+				for (; i + 8 <= n.count; i += 8)
+				{
+					const __m256 dx = _mm256_sub_ps(px, _mm256_loadu_ps(n.posX + i));
+					const __m256 dy = _mm256_sub_ps(py, _mm256_loadu_ps(n.posY + i));
+					const __m256 dist = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)));
+
+					const __m256 inv = _mm256_and_ps(_mm256_cmp_ps(dist, zero, _CMP_GT_OQ), _mm256_div_ps(_mm256_set1_ps(1.f), dist));
+					const __m256 nx = _mm256_mul_ps(dx, inv);
+					const __m256 ny = _mm256_mul_ps(dy, inv);
+
+					const __m256 radii = _mm256_add_ps(r, _mm256_loadu_ps(n.radius + i));
+					const __m256 pen = _mm256_sub_ps(radii, dist);
+
+					const __m256 mag = _mm256_min_ps(_mm256_mul_ps(scale, Exp(_mm256_mul_ps(pen, invD))), maxF);
+					__m256 fx = _mm256_mul_ps(nx, mag);
+					__m256 fy = _mm256_mul_ps(ny, mag);
+
+					const __m256 contact = _mm256_cmp_ps(dist, radii, _CMP_LT_OQ);
+					const __m256 rvx = _mm256_sub_ps(_mm256_loadu_ps(n.velX + i), vx);
+					const __m256 rvy = _mm256_sub_ps(_mm256_loadu_ps(n.velY + i), vy);
+					const __m256 tDot = _mm256_and_ps(absMask, _mm256_sub_ps(_mm256_mul_ps(rvx, ny), _mm256_mul_ps(rvy, nx)));
+
+					const __m256 push = _mm256_mul_ps(body, pen);
+					const __m256 slide = _mm256_mul_ps(_mm256_mul_ps(fric, pen), tDot);
+
+					fx = _mm256_add_ps(fx, _mm256_and_ps(contact, _mm256_add_ps(_mm256_mul_ps(nx, push), _mm256_mul_ps(ny, slide))));
+					fy = _mm256_add_ps(fy, _mm256_and_ps(contact, _mm256_sub_ps(_mm256_mul_ps(ny, push), _mm256_mul_ps(nx, slide))));
+
+					sumX = _mm256_add_ps(sumX, fx);
+					sumY = _mm256_add_ps(sumY, fy);
+				}
+
+				outX += HorizontalSum(sumX);
+				outY += HorizontalSum(sumY);
+				return i;
+			}
+#pragma endregion
+
+			KernelIsa DetectIsa()
+			{
+#if defined(_MSC_VER)
+				int info[4];
+				__cpuid(info, 0);
+				const int maxLeaf = info[0];
+
+				__cpuid(info, 1);
+				const bool sse2 = (info[3] & (1 << 26)) != 0;
+				const bool osxsave = (info[2] & (1 << 27)) != 0;
+				const bool avx = (info[2] & (1 << 28)) != 0;
+
+				// OS has to save ymm registers on context switch
+				const bool ymmEnabled = osxsave && avx && (_xgetbv(0) & 0x6) == 0x6;
+
+				bool avx2 = false;
+				if (maxLeaf >= 7)
+				{
+					__cpuidex(info, 7, 0);
+					avx2 = (info[1] & (1 << 5)) != 0;
+				}
+
+				if (ymmEnabled && avx2)
+					return KernelIsa::Avx2;
+				if (sse2)
+					return KernelIsa::Sse;
+				return KernelIsa::Scalar;
+#else
+				__builtin_cpu_init();
+				if (__builtin_cpu_supports("avx2"))
+					return KernelIsa::Avx2;
+				if (__builtin_cpu_supports("sse2"))
+					return KernelIsa::Sse;
+				return KernelIsa::Scalar;
+#endif
+			}
+		}
+
+		KernelIsa BestAvailableIsa()
+		{
+			static const KernelIsa isa = DetectIsa();
+			return isa;
+		}
+
+		void AgentForces(
+			KernelIsa isa, const ForceParams & params,
+			float posX, float posY, float velX, float velY, float radius,
+			const NeighborArrays & neighbors,
+			float & outForceX, float & outForceY)
+		{
+			const Vector2 pos(posX, posY);
+			const Vector2 vel(velX, velY);
+
+			float fx = 0.f;
+			float fy = 0.f;
+			size_t done = 0;
+
+			// Requested set is clamped to what the machine supports
+			isa = std::min(isa, BestAvailableIsa());
+
+			if (isa == KernelIsa::Avx2)
+				done = SumAvx2(params, pos, vel, radius, neighbors, done, fx, fy);
+			if (isa >= KernelIsa::Sse)
+				done = SumSse(params, pos, vel, radius, neighbors, done, fx, fy);
+
+			const Vector2 tail = SumScalar(params, pos, vel, radius, neighbors, done);
+
+			outForceX = fx + tail.x;
+			outForceY = fy + tail.y;
+		}
+	}
+}
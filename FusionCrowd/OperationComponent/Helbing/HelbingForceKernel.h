@@ -0,0 +1,50 @@
+#pragma once
+
+#include "Export/Config.h"
+
+#include <cstddef>
+
+namespace FusionCrowd
+{
+	namespace Helbing
+	{
+		enum class KernelIsa
+		{
+			Scalar,
+			Sse,
+			Avx2
+		};
+
+		struct ForceParams
+		{
+			float agentScale;
+			float forceDistance;
+			float bodyForce;
+			float friction;
+		};
+
+		// Neighbour data as separate arrays, all of length count
+		struct NeighborArrays
+		{
+			const float * posX;
+			const float * posY;
+			const float * velX;
+			const float * velY;
+			const float * radius;
+			size_t count;
+		};
+
+		// Widest instruction set supported by both CPU and OS, checked once
+		FUSION_CROWD_API KernelIsa BestAvailableIsa();
+
+		// Sum of agent-agent social forces acting on the agent.
+		// Vector paths process 8 (Avx2) or 4 (Sse) neighbours at once and differ
+		// from the scalar path only by summation order and exp approximation.
+		FUSION_CROWD_API void AgentForces(
+			KernelIsa isa, const ForceParams & params,
+			float posX, float posY, float velX, float velY, float radius,
+			const NeighborArrays & neighbors,
+			float & outForceX, float & outForceY
+		);
+	}
+}
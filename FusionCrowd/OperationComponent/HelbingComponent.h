@@ -9,6 +9,8 @@
 #include "Navigation/NeighborInfo.h"
 #include "Navigation/AgentSpatialInfo.h"
 
+#include "OperationComponent/Helbing/HelbingForceKernel.h"
+
 #include <map>
 
 namespace FusionCrowd
@@ -42,9 +44,12 @@ namespace FusionCrowd
 
 			void Update(float timeStep) override;
 
+			// Instruction set of the agent force kernel, the best supported one by default
+			void SetKernelIsa(KernelIsa isa) { _kernelIsa = isa; }
+			KernelIsa GetKernelIsa() const { return _kernelIsa; }
+
 		private:
 			void ComputeNewVelocity(AgentSpatialInfo & agent, float timeStep);
-			DirectX::SimpleMath::Vector2 AgentForce(AgentSpatialInfo* agent, NeighborInfo * other) const;
 			DirectX::SimpleMath::Vector2 ObstacleForce(AgentSpatialInfo* agent, Obstacle * obst) const;
 			DirectX::SimpleMath::Vector2 DrivingForce(AgentSpatialInfo* agent);
 
@@ -58,6 +63,8 @@ namespace FusionCrowd
 			float _bodyForse;
 			float _friction;
 			float _forceDistance;
+
+			KernelIsa _kernelIsa;
 		};
 	}
 }
\ No newline at end of file
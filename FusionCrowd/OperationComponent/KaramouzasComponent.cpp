@@ -6,6 +6,7 @@
 
 #include "Navigation/AgentSpatialInfo.h"
 #include "Navigation/Obstacle.h"
+#include "OperationComponent/ParallelAgents.h"
 
 #include <algorithm>
 #include <list>
@@ -66,12 +67,20 @@ namespace FusionCrowd
 
 			void Update(float timeStep)
 			{
-				for(auto p : _agents)
+				// Noise is drawn serially in agent order, so rand() is called
+				// in the same sequence whatever the thread count
+				for (auto & p : _agents)
 				{
-					auto id = p.first;
-					AgentSpatialInfo & agent = _navSystem->GetSpatialInfo(id);
-					ComputeNewVelocity(agent, timeStep);
+					//float angle = rand() * 2.0f * M_PI / RAND_MAX;
+					float angle = rand() * 2.0f * 3.1415f / RAND_MAX;
+					float dist = rand() * 0.001f / RAND_MAX;
+					p.second._noise = dist * Vector2(cos(angle), sin(angle));
 				}
+
+				ParallelForAgents(*_navSystem, _agents, [this, timeStep](AgentSpatialInfo & agent, AgentParamentrs & params)
+				{
+					ComputeNewVelocity(agent, params, timeStep);
+				});
 			}
 
 		private:
@@ -79,15 +88,23 @@ namespace FusionCrowd
 			struct SpatialInfoWithCollisionTime
 			{
 				float tc;
-				NeighborInfo info;
+				const NeighborInfo * info;
 			};
 
-			void ComputeNewVelocity(AgentSpatialInfo & agent, float timeStep)
+			// Per-thread candidate buffer, keeps its capacity between agents and steps
+			static std::vector<SpatialInfoWithCollisionTime> & CollidingScratch()
+			{
+				thread_local std::vector<SpatialInfoWithCollisionTime> collidingSet;
+				collidingSet.clear();
+				return collidingSet;
+			}
+
+			void ComputeNewVelocity(AgentSpatialInfo & agent, const AgentParamentrs & params, float timeStep)
 			{
 				const float EPSILON = 0.01f; // this eps from Ioannis
 				const float FOV = _cosFOVAngle;
 
-				Vector2 force((agent.prefVelocity.getPreferredVel() - agent.GetVel()) / _reactionTime);
+				Vector2 force((agent.GetPrefVelocity().getPreferredVel() - agent.GetVel()) / _reactionTime);
 				const float SAFE_DIST = _wallDistance + agent.radius;
 				const float SAFE_DIST2 = SAFE_DIST * SAFE_DIST;
 
@@ -124,11 +141,12 @@ namespace FusionCrowd
 				bool VERBOSE = false; // _id == 1;
 				if (VERBOSE) std::cout << "Agent " << agent.id << "\n";
 				float totalTime = 1.f;
+				std::vector<SpatialInfoWithCollisionTime> & collidingSet = CollidingScratch();
 
 				auto const & neighbours = _navSystem->GetNeighbours(agent.id);
 				for (const auto & other : neighbours)
 				{
-					float circRadius = _agents[agent.id]._perSpace + other.radius;
+					float circRadius = params._perSpace + other.radius;
 					Vector2 relVel = desVel - other.vel;
 					Vector2 relPos = other.pos - agent.GetPos();
 
@@ -137,10 +155,9 @@ namespace FusionCrowd
 							colliding = true;
 
 							collidingSet.clear();
-							collidingSet.reserve(neighbours.size());
 						}
 						//collidingSet.push({.0f, other});
-						collidingSet.push_back({.0f, other});
+						collidingSet.push_back({.0f, &other});
 						if (static_cast<int>(collidingSet.size()) > collidingCount) ++collidingCount;
 						continue;
 					}
@@ -151,7 +168,7 @@ namespace FusionCrowd
 					relPos.Normalize(relDir);
 					if (relDir.Dot(agent.GetOrient()) < FOV) continue;
 					float tc = Math::rayCircleTTC(relVel, relPos, circRadius);
-					if (tc < _agents[agent.id]._anticipation && !colliding) {
+					if (tc < params._anticipation && !colliding) {
 						if (VERBOSE) std::cout << "\tAgent " << other.id << " t_c: " << tc << "\n";
 						//totalTime += tc;
 						// insert into colliding set (in order)
@@ -161,17 +178,24 @@ namespace FusionCrowd
 						while (itr != collidingSet.end() && tc > itr->tc) ++itr;
 						collidingSet.insert(itr, {tc, other});
 						*/
-						collidingSet.push_back({tc, other});
+						collidingSet.push_back({tc, &other});
 					}
 				}
 
-				auto cmp = [](const SpatialInfoWithCollisionTime & left, const SpatialInfoWithCollisionTime & right) { return left.tc < right.tc; };
-				std::sort(collidingSet.begin(), collidingSet.end(), cmp);
+				// As in Menge, only the collidingCount earliest collisions that produce a force are
+				// weighted in. Overlapping agents raise collidingCount, so all of them are kept when
+				// colliding. The min-heap yields candidates in tc order only as far as needed.
+				auto later = [](const SpatialInfoWithCollisionTime & left, const SpatialInfoWithCollisionTime & right) { return left.tc > right.tc; };
+				std::make_heap(collidingSet.begin(), collidingSet.end(), later);
 
 				int count = 0;
-				for (auto itr = collidingSet.begin(); itr != collidingSet.end(); ++itr) {
-					const auto& other = itr->info;
-					float tc = itr->tc;
+				auto heapEnd = collidingSet.end();
+				while (count < collidingCount && heapEnd != collidingSet.begin()) {
+					std::pop_heap(collidingSet.begin(), heapEnd, later);
+					--heapEnd;
+
+					const auto& other = *heapEnd->info;
+					float tc = heapEnd->tc;
 					// future positions
 					Vector2 myPos = agent.GetPos() + desVel * tc;
 					Vector2 hisPos = other.pos + other.vel * tc;
@@ -211,10 +235,7 @@ namespace FusionCrowd
 					force += forceDir * (mag * weight);
 				}
 				// Add some noise to avoid deadlocks and introduce variation
-				//float angle = rand() * 2.0f * M_PI / RAND_MAX;
-				float angle = rand() * 2.0f * 3.1415f / RAND_MAX;
-				float dist = rand() * 0.001f / RAND_MAX;
-				force += dist * Vector2(cos(angle), sin(angle));
+				force += params._noise;
 				// do we need a drag force?
 
 				 // Cap the force to maxAccel
@@ -224,10 +245,9 @@ namespace FusionCrowd
 					force *= agent.maxAccel;
 				}
 
-				agent.velNew = desVel + force * timeStep;	// assumes unit mass
+				agent.SetVelNew(desVel + force * timeStep);	// assumes unit mass
 			}
 
-			std::vector<SpatialInfoWithCollisionTime> collidingSet;
 			std::shared_ptr<NavSystem> _navSystem;
 			std::map<int, AgentParamentrs> _agents;
 			float _orientWeight;
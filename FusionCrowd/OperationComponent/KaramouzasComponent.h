@@ -18,6 +18,8 @@ namespace FusionCrowd
 		{
 			float _perSpace;
 			float _anticipation;
+			// Noise force of the current step, drawn before agents are updated
+			DirectX::SimpleMath::Vector2 _noise;
 
 			AgentParamentrs() :_perSpace(0.69f), _anticipation(8.f)
 			{
@@ -7,7 +7,6 @@
 #include <limits>
 #include <vector>
 #include <set>
-#include <thread>
 
 using namespace  DirectX::SimpleMath;
 
@@ -18,8 +17,8 @@ namespace ORCA
 	ORCAComponent::ORCAComponent(std::shared_ptr<NavSystem> navSystem) : ORCAComponent(navSystem, 2.5f, 0.15f)
 	{}
 
-	ORCAComponent::ORCAComponent(std::shared_ptr<NavSystem> navSystem, float timeHorizon, float timeHorizonObst)
-		: _navSystem(navSystem), _timeHorizon(timeHorizon), _timeHorizonObst(timeHorizonObst), _pool(1) //std::thread::hardware_concurrency() - 1)
+	ORCAComponent::ORCAComponent(std::shared_ptr<NavSystem> navSystem, float timeHorizon, float timeHorizonObst, size_t maxNeighbors)
+		: _navSystem(navSystem), _timeHorizon(timeHorizon), _timeHorizonObst(timeHorizonObst), _maxNeighbors(maxNeighbors)
 	{}
 
 	void ORCAComponent::AddAgent(size_t id)
@@ -27,6 +26,7 @@ namespace ORCA
 		_agents.insert(id);
 		_navSystem->GetSpatialInfo(id).inertiaEnabled = false;
 		_navSystem->GetSpatialInfo(id).maxAngVel = 60.0f;
+		_navSystem->GetSpatialInfo(id).maxNeighbors = _maxNeighbors;
 	}
 
 	bool ORCAComponent::DeleteAgent(size_t id)
@@ -36,61 +36,69 @@ namespace ORCA
 		return true;
 	}
 
-	struct Task
+	namespace
 	{
-		AgentSpatialInfo & agent;
-		std::future<Vector2> newSpeed;
-	};
+		// Per-thread scratch reused between agents and steps
+		struct LinesScratch
+		{
+			std::vector<Math::Line> orcaLines;
+			std::vector<Math::Line> projLines;
+		};
+
+		thread_local LinesScratch t_scratch;
+	}
 
 	void ORCAComponent::Update(float timeStep)
 	{
-		std::vector<Task> tasks;
-		for(size_t agentId : _agents)
-		{
-			auto & info = _navSystem->GetSpatialInfo(agentId);
-
-			EnvironmentArgs args {
-				_timeHorizon,
-				_timeHorizonObst,
-				timeStep,
-				info,
-				_navSystem->GetClosestObstacles(agentId),
-				_navSystem->GetNeighbours(agentId)
-			};
-
-			tasks.push_back({info, _pool.push([=](int threadId) { return ComputeNewVelocity(args); })});
-		}
+		_agentIds.assign(_agents.begin(), _agents.end());
 
-		for(auto & t : tasks)
+		_navSystem->GetScheduler().ParallelFor(_agentIds.size(), [this, timeStep](size_t begin, size_t end)
 		{
-			t.agent.velNew = t.newSpeed.get();
-		}
+			LinesScratch & scratch = t_scratch;
+			for(size_t i = begin; i < end; i++)
+			{
+				const size_t agentId = _agentIds[i];
+				AgentSpatialInfo & info = _navSystem->GetSpatialInfo(agentId);
+
+				const EnvironmentArgs args {
+					_timeHorizon,
+					_timeHorizonObst,
+					timeStep,
+					info,
+					_navSystem->GetClosestObstacles(agentId),
+					_navSystem->GetNeighbours(agentId)
+				};
+
+				// Only this agent's own velNew is written, everything else is read
+				info.SetVelNew(ComputeNewVelocity(args, scratch.orcaLines, scratch.projLines));
+			}
+		}, UPDATE_GRAIN);
 	}
 
-	Vector2 ORCAComponent::ComputeNewVelocity(EnvironmentArgs args)
+	Vector2 ORCAComponent::ComputeNewVelocity(const EnvironmentArgs & args, std::vector<Math::Line>& orcaLines, std::vector<Math::Line>& projLines)
 	{
-		std::vector<Math::Line> orcaLines;
+		orcaLines.clear();
 		Vector2 result;
  		const size_t numObstLines = ComputeORCALines(orcaLines, args);
 
-		Vector2 velPref(args.info.prefVelocity.getPreferredVel());
+		Vector2 velPref(args.info.GetPrefVelocity().getPreferredVel());
 
 		size_t lineFail = LinearProgram2(orcaLines, args.info.maxSpeed, velPref, false, result);
 
 		if (lineFail < orcaLines.size()) {
-			LinearProgram3(orcaLines, numObstLines, lineFail, args.info.maxSpeed, result);
+			LinearProgram3(orcaLines, numObstLines, lineFail, args.info.maxSpeed, result, projLines);
 		}
 
 		return result;
 	}
 
-	size_t ORCAComponent::ComputeORCALines(std::vector<Math::Line>& _orcaLines, EnvironmentArgs & args)
+	size_t ORCAComponent::ComputeORCALines(std::vector<Math::Line>& _orcaLines, const EnvironmentArgs & args)
 	{
 		const float invTimeHorizonObst = 1.0f / args.timeHorizonObst;
 
 		/* Create obstacle ORCA lines. */
 
-		for (Obstacle & obst : args.obstacles) {
+		for (const Obstacle & obst : args.obstacles) {
 			const Vector2 P0 = obst.getP0();
 			const Vector2 P1 = obst.getP1();
 			const bool agtOnRight = FusionCrowd::Math::leftOf(P0, P1, args.info.GetPos()) < 0.f;
@@ -176,7 +184,7 @@ namespace ORCA
 		return numObstLines;
 	}
 
-	void ORCAComponent::ObstacleLine(std::vector<FusionCrowd::Math::Line>& _orcaLines, Obstacle & obst, const float invTau, bool flip, const AgentSpatialInfo& agentInfo)
+	void ORCAComponent::ObstacleLine(std::vector<FusionCrowd::Math::Line>& _orcaLines, const Obstacle & obst, const float invTau, bool flip, const AgentSpatialInfo& agentInfo)
 	{
 		const float LENGTH = obst.length();
 		const Vector2 P0 = flip ? obst.getP1() : obst.getP0();
@@ -509,14 +517,14 @@ namespace ORCA
 	}
 
 	void ORCAComponent::LinearProgram3(const std::vector<FusionCrowd::Math::Line>& lines, size_t numObstLines,
-		size_t beginLine, float radius, Vector2& result)
+		size_t beginLine, float radius, Vector2& result, std::vector<Math::Line>& projLines)
 	{
 		float distance = 0.0f;
 
 		for (size_t i = beginLine; i < lines.size(); ++i) {
 			if (Math::det(lines[i]._direction, lines[i]._point - result) > distance) {
 				/* Result does not satisfy constraint of line i. */
-				std::vector<Math::Line> projLines(lines.begin(), lines.begin() + numObstLines);
+				projLines.assign(lines.begin(), lines.begin() + numObstLines);
 
 				for (size_t j = numObstLines; j < i; ++j) {
 					Math::Line line;
@@ -2,6 +2,7 @@
 
 #include <memory>
 #include <set>
+#include <vector>
 
 #include "Simulator.h"
 
@@ -16,8 +17,6 @@
 #include "OperationComponent/IOperationComponent.h"
 #include "Export/ComponentId.h"
 
-#include "Util/ctpl_stl.h"
-
 namespace FusionCrowd
 {
 	namespace ORCA
@@ -32,13 +31,17 @@ namespace FusionCrowd
 				float timeStep;
 
 				const AgentSpatialInfo& info;
-				std::vector<Obstacle> obstacles;
-				std::vector<NeighborInfo> neighbors;
+				Span<Obstacle> obstacles;
+				Span<NeighborInfo> neighbors;
 			};
 
 		public:
+			// Unbounded by default so results do not change, RVO2 uses 10 to bound
+			// the number of agent lines per linear program
+			static const size_t DEFAULT_MAX_NEIGHBORS = AgentSpatialInfo::NO_NEIGHBOR_LIMIT;
+
 			ORCAComponent(std::shared_ptr<NavSystem> navSystem);
-			ORCAComponent(std::shared_ptr<NavSystem> navSystem, float timeHorizon, float timeHorizonObst);
+			ORCAComponent(std::shared_ptr<NavSystem> navSystem, float timeHorizon, float timeHorizonObst, size_t maxNeighbors = DEFAULT_MAX_NEIGHBORS);
 
 			ComponentId GetId() override { return ComponentIds::ORCA_ID; }
 
@@ -48,10 +51,13 @@ namespace FusionCrowd
 			void Update(float timeStep) override;
 
 		private:
-			static DirectX::SimpleMath::Vector2 ComputeNewVelocity(EnvironmentArgs args);
+			static DirectX::SimpleMath::Vector2 ComputeNewVelocity(
+				const EnvironmentArgs & args,
+				std::vector<Math::Line>& orcaLines, std::vector<Math::Line>& projLines
+			);
 
-			static size_t ComputeORCALines(std::vector<Math::Line>& _orcaLines, EnvironmentArgs & args);
-			static void ObstacleLine(std::vector<Math::Line>& _orcaLines, Obstacle & obst, const float invTau, bool flip, const AgentSpatialInfo& info);
+			static size_t ComputeORCALines(std::vector<Math::Line>& _orcaLines, const EnvironmentArgs & args);
+			static void ObstacleLine(std::vector<Math::Line>& _orcaLines, const Obstacle & obst, const float invTau, bool flip, const AgentSpatialInfo& info);
 
 			static bool LinearProgram1(
 				const std::vector<Math::Line>& lines, size_t lineNo,
@@ -68,17 +74,19 @@ namespace FusionCrowd
 			static void LinearProgram3(
 				const std::vector<Math::Line>& lines,
 				size_t numObstLines, size_t beginLine, float radius,
-				DirectX::SimpleMath::Vector2& result
+				DirectX::SimpleMath::Vector2& result, std::vector<Math::Line>& projLines
 			);
 
 		private:
+			static const size_t UPDATE_GRAIN = 32;
+
 			float _timeHorizon;
 			float _timeHorizonObst;
+			size_t _maxNeighbors;
 
 			std::shared_ptr<NavSystem> _navSystem;
 			std::set<size_t> _agents;
-
-			ctpl::thread_pool _pool;
+			std::vector<size_t> _agentIds;
 		};
 	}
 }
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "Navigation/NavSystem.h"
+#include "Navigation/AgentSpatialInfo.h"
+#include "Util/TaskScheduler.h"
+
+#include <vector>
+
+namespace FusionCrowd
+{
+	// Calls func(AgentSpatialInfo &, Params &) for every agent of an operation component
+	// on the NavSystem scheduler. Map entries are gathered first, so workers index a stable
+	// array and do not touch the map. func may write only to its own agent and params.
+	// Scheduler with a single thread runs agents in map order on the calling thread.
+	template <typename Map, typename Func>
+	void ParallelForAgents(NavSystem & navSystem, Map & agents, Func func)
+	{
+		std::vector<typename Map::value_type *> entries;
+		entries.reserve(agents.size());
+		for (auto & entry : agents)
+		{
+			entries.push_back(&entry);
+		}
+
+		navSystem.GetScheduler().ParallelFor(entries.size(), [&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				func(navSystem.GetSpatialInfo(entries[i]->first), entries[i]->second);
+			}
+		});
+	}
+}
@@ -8,6 +8,8 @@
 #include "Math/geomQuery.h"
 #include "Math/Util.h"
 
+#include "OperationComponent/ParallelAgents.h"
+
 #include <algorithm>
 #include <list>
 #include <iostream>
@@ -19,12 +21,12 @@ namespace FusionCrowd
 	namespace PedVO
 	{
 		PedVOComponent::PedVOComponent(std::shared_ptr<NavSystem> navSystem) :
-			_cosObstTurn(1.0f), _sinObstTurn(0.0f), _navSystem(navSystem)
+			_cosObstTurn(1.0f), _sinObstTurn(0.0f), _maxNeighbors(DEFAULT_MAX_NEIGHBORS), _navSystem(navSystem)
 		{
 		}
 
-		PedVOComponent::PedVOComponent(std::shared_ptr<NavSystem> navSystem, float cosObstTurn, float sinObstTurn) :
-			_cosObstTurn(cosObstTurn), _sinObstTurn(sinObstTurn), _navSystem(navSystem)
+		PedVOComponent::PedVOComponent(std::shared_ptr<NavSystem> navSystem, float cosObstTurn, float sinObstTurn, size_t maxNeighbors) :
+			_cosObstTurn(cosObstTurn), _sinObstTurn(sinObstTurn), _maxNeighbors(maxNeighbors), _navSystem(navSystem)
 		{
 		}
 
@@ -41,6 +43,7 @@ namespace FusionCrowd
 		{
 			_agents[agentId] = AgentParamentrs(timeHorizon, timeHorizonObst, turningBias, denseAware, factor, buffer);
 			_navSystem->GetSpatialInfo(agentId).inertiaEnabled = false;
+			_navSystem->GetSpatialInfo(agentId).maxNeighbors = _maxNeighbors;
 		}
 
 		bool PedVOComponent::DeleteAgent(size_t agentId)
@@ -48,19 +51,41 @@ namespace FusionCrowd
 			return _agents.erase(agentId) > 0;
 		}
 
+		namespace
+		{
+			// Per-thread scratch reused between agents and steps
+			struct LinesScratch
+			{
+				std::vector<Math::Line> orcaLines;
+				std::vector<Math::Line> projLines;
+			};
+
+			thread_local LinesScratch t_scratch;
+		}
+
 		void PedVOComponent::Update(float timeStep)
 		{
+			// Right of way is drawn serially in agent and neighbour order, so rand()
+			// is called in the same sequence whatever the thread count
 			for(auto & p : _agents)
 			{
-				size_t id = p.first;
-				AgentParamentrs & params = p.second;
-				AgentSpatialInfo & spatialInfo = _navSystem->GetSpatialInfo(id);
-
-				ComputeNewVelocity(params, spatialInfo, timeStep);
+				std::vector<float> & rightOfWay = p.second._rightOfWay;
+				rightOfWay.clear();
+				for(size_t i = 0; i < _navSystem->GetNeighbours(p.first).size(); i++)
+				{
+					rightOfWay.push_back(rand());
+				}
 			}
+
+			ParallelForAgents(*_navSystem, _agents, [this, timeStep](AgentSpatialInfo & spatialInfo, AgentParamentrs & params)
+			{
+				LinesScratch & scratch = t_scratch;
+				ComputeNewVelocity(params, spatialInfo, timeStep, scratch.orcaLines, scratch.projLines);
+			});
 		}
 
-		void PedVOComponent::ComputeNewVelocity(AgentParamentrs & agentParams, AgentSpatialInfo & agentInfo, float timeStep)
+		void PedVOComponent::ComputeNewVelocity(AgentParamentrs & agentParams, AgentSpatialInfo & agentInfo, float timeStep,
+			std::vector<Math::Line> & orcaLines, std::vector<Math::Line> & projLines)
 		{
 			AdaptPreferredVelocity(agentParams, agentInfo);
 
@@ -68,17 +93,18 @@ namespace FusionCrowd
 			Vector2 prefDir;
 			float prefSpeed;
 
-			const size_t numObstLines = ComputeORCALinesTurning(agentParams, agentInfo, optVel, prefDir, timeStep, prefSpeed);
+			const size_t numObstLines = ComputeORCALinesTurning(agentParams, agentInfo, optVel, prefDir, timeStep, prefSpeed, orcaLines);
 
-			size_t lineFail = LinearProgram2(_orcaLines, agentInfo.maxSpeed, optVel, false, agentParams._turningBias, agentInfo.velNew);
+			Vector2 velNew = agentInfo.GetVelNew();
+			size_t lineFail = LinearProgram2(orcaLines, agentInfo.maxSpeed, optVel, false, agentParams._turningBias, velNew);
 
-			if (lineFail < _orcaLines.size()) {
-				LinearProgram3(_orcaLines, numObstLines, lineFail, agentInfo.maxSpeed, agentParams._turningBias, agentInfo.velNew);
+			if (lineFail < orcaLines.size()) {
+				LinearProgram3(orcaLines, numObstLines, lineFail, agentInfo.maxSpeed, agentParams._turningBias, velNew, projLines);
 			}
 			if (agentParams._turningBias != 1.f && prefSpeed > Math::EPS) {
 				// Transform _velNew from affine space to real space
 				// Undo the scale
-				Vector2 vel(agentInfo.velNew.x, agentInfo.velNew.y * agentParams._turningBias);
+				Vector2 vel(velNew.x, velNew.y * agentParams._turningBias);
 				// Rotate it back
 				// Flip the y-value so I perform rotation in the other direction
 				//	I'm multiplying v * R, where R is the matrix:
@@ -92,15 +118,16 @@ namespace FusionCrowd
 				Vector2 n(-prefDir.y, prefDir.x);
 				float vx = vel.Dot(prefDir);
 				float vy = vel.Dot(n);
-				agentInfo.velNew = Vector2(vx, vy);
+				velNew = Vector2(vx, vy);
 			}
+			agentInfo.SetVelNew(velNew);
 		}
 
 		void PedVOComponent::AdaptPreferredVelocity(AgentParamentrs & agentParams, AgentSpatialInfo & agentInfo)
 		{
 			if (agentParams._denseAware) {
-				float prefSpeed = agentInfo.prefVelocity.getSpeed();
-				Vector2 prefDir(agentInfo.prefVelocity.getPreferred());
+				float prefSpeed = agentInfo.GetPrefVelocity().getSpeed();
+				Vector2 prefDir(agentInfo.GetPrefVelocity().getPreferred());
 				// start assuming there is infinite space
 				float availSpace = 1e6f;
 
@@ -151,31 +178,33 @@ namespace FusionCrowd
 
 				// Compute the maximum speed I could take for the available space
 				float maxSpeed = agentParams._speedConst * availSpace * availSpace;
-				if (maxSpeed < prefSpeed) agentInfo.prefVelocity.setSpeed(maxSpeed);
+				if (maxSpeed < prefSpeed) agentInfo.GetPrefVelocity().setSpeed(maxSpeed);
 			}
 		}
 
 		size_t PedVOComponent::ComputeORCALinesTurning(
 			AgentParamentrs & agentParams, AgentSpatialInfo & agentInfo,
-			DirectX::SimpleMath::Vector2& optVel, DirectX::SimpleMath::Vector2& prefDir, float timeStep, float& prefSpeed)
+			DirectX::SimpleMath::Vector2& optVel, DirectX::SimpleMath::Vector2& prefDir, float timeStep, float& prefSpeed,
+			std::vector<Math::Line> & orcaLines)
 		{
-			_orcaLines.clear();
+			orcaLines.clear();
 
 			const float invTimeHorizonObst = 1.0f / agentParams._timeHorizonObst;
 
-			for (Obstacle & obst : _navSystem->GetClosestObstacles(agentInfo.id))
+			for (const Obstacle & obst : _navSystem->GetClosestObstacles(agentInfo.id))
 			{
 				const Vector2 P0 = obst.getP0();
 				const Vector2 P1 = obst.getP1();
 				const bool agtOnRight = Math::leftOf(P0, P1, agentInfo.GetPos()) < 0.f;
 
-				ObstacleLine(agentParams, agentInfo, obst, invTimeHorizonObst, !agtOnRight && obst._doubleSided);
+				ObstacleLine(agentParams, agentInfo, obst, invTimeHorizonObst, !agtOnRight && obst._doubleSided, orcaLines);
 			}
 
-			const size_t numObstLines = _orcaLines.size();
+			const size_t numObstLines = orcaLines.size();
 
 			const float invTimeHorizon = 1.0f / agentParams._timeHorizon;
 			/* Create agent ORCA lines. */
+			size_t neighbourIdx = 0;
 			for (auto & other : _navSystem->GetNeighbours(agentInfo.id))
 			{
 				const Vector2 relativePosition = other.pos - agentInfo.GetPos();
@@ -185,7 +214,7 @@ namespace FusionCrowd
 				//if (rightOfWay > 1.f)
 				//	rightOfWay = 1.f;
 				//
-				float rightOfWay = rand();
+				float rightOfWay = agentParams._rightOfWay[neighbourIdx++];
 
 				// Right of way-dependent calculations
 				Vector2 myVel = agentInfo.GetVel();
@@ -213,9 +242,9 @@ namespace FusionCrowd
 				{
 					// my advantage
 					weight -= 0.5f * rightOfWay;
-					myVel = agentInfo.prefVelocity.getPreferredVel() * rightOfWay + (1.f - rightOfWay) * agentInfo.GetVel();
+					myVel = agentInfo.GetPrefVelocity().getPreferredVel() * rightOfWay + (1.f - rightOfWay) * agentInfo.GetVel();
 					if ((myVel - agentInfo.GetVel()).LengthSquared() > MAX_DEV_SQD) {
-						(agentInfo.prefVelocity.getPreferredVel() - agentInfo.GetVel()).Normalize(myVel);
+						(agentInfo.GetPrefVelocity().getPreferredVel() - agentInfo.GetVel()).Normalize(myVel);
 						myVel = myVel * MAX_DEV + agentInfo.GetVel();
 					}
 				}
@@ -287,34 +316,34 @@ namespace FusionCrowd
 					line._point = myVel + weight * u;
 				}
 
-				_orcaLines.push_back(line);
+				orcaLines.push_back(line);
 			}
 
 			// Transform the lines
 			if (agentParams._turningBias != 1.f) {
-				prefSpeed = agentInfo.prefVelocity.getSpeed();
+				prefSpeed = agentInfo.GetPrefVelocity().getSpeed();
 				optVel = Vector2(prefSpeed, 0.f);
 				// Transformation is dependent on prefSpeed being non-zero
 				if (prefSpeed > Math::EPS) {
-					prefDir = Vector2(agentInfo.prefVelocity.getPreferred());
+					prefDir = Vector2(agentInfo.GetPrefVelocity().getPreferred());
 					Vector2 n(-prefDir.y, prefDir.x);
 					// rotate and scale all of the lines
 					float turnInv = 1.f / agentParams._turningBias;
-					for (size_t i = 0; i < _orcaLines.size(); ++i) {
+					for (size_t i = 0; i < orcaLines.size(); ++i) {
 						// Make sure I'm not perpendicular
 						// turning threshhold is bigger than zero degrees
 						if (_cosObstTurn < 1.f &&
 							// only tilt if I'm seeking to magnify differences
 							agentParams._turningBias > 1.f && i >= numObstLines &&  // don't perturb obstacles
-							Math::det(_orcaLines[i]._direction,
+							Math::det(orcaLines[i]._direction,
 								// preferred velocity is not feasible w.r.t. this obstacle
-								_orcaLines[i]._point - agentInfo.prefVelocity.getPreferredVel()) > 0.0f &&
+								orcaLines[i]._point - agentInfo.GetPrefVelocity().getPreferredVel()) > 0.0f &&
 							// This is a trick: det with the line direction, is dot product with normal
 							// angle between pref vel and line norm is less than 1/2 degree either way
-							Math::det(-_orcaLines[i]._direction, prefDir) > _cosObstTurn) {
+							Math::det(-orcaLines[i]._direction, prefDir) > _cosObstTurn) {
 							// Compute the intersection with the circle of maximum velocity
-							float dotProduct = _orcaLines[i]._point.Dot(_orcaLines[i]._direction);
-							float discriminant = pow(dotProduct, 2) + pow(agentInfo.maxSpeed, 2) - _orcaLines[i]._point.LengthSquared();
+							float dotProduct = orcaLines[i]._point.Dot(orcaLines[i]._direction);
+							float discriminant = pow(dotProduct, 2) + pow(agentInfo.maxSpeed, 2) - orcaLines[i]._point.LengthSquared();
 							if (discriminant >= 0.f) {
 								// Intersects the circle of maximum speed
 								// I already know from the previous test that the preferred velocity
@@ -322,55 +351,56 @@ namespace FusionCrowd
 								// intersection, the whole circle must be infeasible. don't bother
 								// perturbing.
 								const float sqrtDiscriminant = std::sqrt(discriminant);
-								if (agentInfo.GetVel().Dot(_orcaLines[i]._direction) > 0.f) {
+								if (agentInfo.GetVel().Dot(orcaLines[i]._direction) > 0.f) {
 									float t = -dotProduct + sqrtDiscriminant;
 									// new line point
-									Vector2 p = _orcaLines[i]._point + t * _orcaLines[i]._direction;
+									Vector2 p = orcaLines[i]._point + t * orcaLines[i]._direction;
 									// clockwise rotation
 									const Vector2 rx(_cosObstTurn, _sinObstTurn);
 									const Vector2 ry(-_sinObstTurn, _cosObstTurn);
 									float dx = Math::det(prefDir, rx);
 									float dy = Math::det(prefDir, ry);
-									_orcaLines[i]._direction = Vector2(dx, dy);
-									_orcaLines[i]._point = p;
+									orcaLines[i]._direction = Vector2(dx, dy);
+									orcaLines[i]._point = p;
 								}
 								else {
 									float t = -dotProduct - sqrtDiscriminant;
 									// new line point
-									Vector2 p = _orcaLines[i]._point + t * _orcaLines[i]._direction;
+									Vector2 p = orcaLines[i]._point + t * orcaLines[i]._direction;
 									// counter-clockwise rotation
 									const Vector2 rx(_cosObstTurn, -_sinObstTurn);
 									const Vector2 ry(_sinObstTurn, _cosObstTurn);
 									float dx = Math::det(prefDir, rx);
 									float dy = Math::det(prefDir, ry);
-									_orcaLines[i]._direction = Vector2(dx, dy);
-									_orcaLines[i]._point =p;
+									orcaLines[i]._direction = Vector2(dx, dy);
+									orcaLines[i]._point =p;
 								}
 							}
 						}
 
 						// rotate
-						float px = _orcaLines[i]._point.Dot(prefDir);
-						float py = _orcaLines[i]._point.Dot(n);
-						float dx = _orcaLines[i]._direction.Dot(prefDir);
-						float dy = _orcaLines[i]._direction.Dot(n);
+						float px = orcaLines[i]._point.Dot(prefDir);
+						float py = orcaLines[i]._point.Dot(n);
+						float dx = orcaLines[i]._direction.Dot(prefDir);
+						float dy = orcaLines[i]._direction.Dot(n);
 						// scale
 						py *= turnInv;
 						dy *= turnInv;
 						// set
-						_orcaLines[i]._point = Vector2(px, py);
-						(Vector2(dx, dy)).Normalize(_orcaLines[i]._direction);
+						orcaLines[i]._point = Vector2(px, py);
+						(Vector2(dx, dy)).Normalize(orcaLines[i]._direction);
 					}
 				}
 			}
 			else {
-				optVel = (agentInfo.prefVelocity.getPreferredVel());
+				optVel = (agentInfo.GetPrefVelocity().getPreferredVel());
 			}
 
 			return numObstLines;
 		}
 
-		void PedVOComponent::ObstacleLine(AgentParamentrs & agentParams, AgentSpatialInfo & agentInfo, Obstacle & obst, const float invTau, bool flip)
+		void PedVOComponent::ObstacleLine(AgentParamentrs & agentParams, AgentSpatialInfo & agentInfo, const Obstacle & obst, const float invTau, bool flip,
+			std::vector<Math::Line> & orcaLines)
 		{
 			const float LENGTH = obst.length();
 			const Vector2 P0 = flip ? obst.getP1() : obst.getP0();
@@ -390,11 +420,11 @@ namespace FusionCrowd
 			 */
 			bool alreadyCovered = false;
 
-			for (size_t j = 0; j < _orcaLines.size(); ++j) {
-				if (Math::det(invTau * relativePosition1 - _orcaLines[j]._point, _orcaLines[j]._direction) -
+			for (size_t j = 0; j < orcaLines.size(); ++j) {
+				if (Math::det(invTau * relativePosition1 - orcaLines[j]._point, orcaLines[j]._direction) -
 					invTau * agentInfo.radius >=
 					-Math::EPS &&
-					Math::det(invTau * relativePosition2 - _orcaLines[j]._point, _orcaLines[j]._direction) -
+					Math::det(invTau * relativePosition2 - orcaLines[j]._point, orcaLines[j]._direction) -
 					invTau * agentInfo.radius >=
 					-Math::EPS) {
 					alreadyCovered = true;
@@ -423,7 +453,7 @@ namespace FusionCrowd
 				if (p0Convex) {
 					line._point = Vector2(0.f, 0.f);
 					(Vector2(-relativePosition1.y, relativePosition1.x)).Normalize(line._direction);
-					_orcaLines.push_back(line);
+					orcaLines.push_back(line);
 				}
 				return;
 			}
@@ -434,7 +464,7 @@ namespace FusionCrowd
 					(p1Convex && Math::det(relativePosition2, obst._nextObstacle->_unitDir) >= 0)) {
 					line._point = Vector2(0.f, 0.f);
 					(Vector2(-relativePosition2.y, relativePosition2.x)).Normalize(line._direction);
-					_orcaLines.push_back(line);
+					orcaLines.push_back(line);
 				}
 				return;
 			}
@@ -442,7 +472,7 @@ namespace FusionCrowd
 				/* Collision with obstacle segment. */
 				line._point = Vector2(0.f, 0.f);
 				line._direction = -obstDir;
-				_orcaLines.push_back(line);
+				orcaLines.push_back(line);
 				return;
 			}
 
@@ -573,7 +603,7 @@ namespace FusionCrowd
 				(agentInfo.GetVel() - leftCutoff).Normalize(unitW);
 				line._direction = Vector2(unitW.y, -unitW.x);
 				line._point = leftCutoff + agentInfo.radius * invTau * unitW;
-				_orcaLines.push_back(line);
+				orcaLines.push_back(line);
 				return;
 			}
 			else if (t > 1.0f && tRight < 0.0f) {
@@ -582,7 +612,7 @@ namespace FusionCrowd
 				(agentInfo.GetVel() - rightCutoff).Normalize(unitW);
 				line._direction = Vector2(unitW.y, -unitW.x);
 				line._point = rightCutoff + agentInfo.radius * invTau * unitW;
-				_orcaLines.push_back(line);
+				orcaLines.push_back(line);
 				return;
 			}
 
@@ -604,7 +634,7 @@ namespace FusionCrowd
 				line._direction = -obstDir;
 				line._point =
 					leftCutoff + agentInfo.radius * invTau * Vector2(-line._direction.y, line._direction.x);
-				_orcaLines.push_back(line);
+				orcaLines.push_back(line);
 			}
 			else if (distSqLeft <= distSqRight) {
 				/* Project on left leg. */
@@ -612,7 +642,7 @@ namespace FusionCrowd
 					line._direction = leftLegDirection;
 					line._point =
 						leftCutoff + agentInfo.radius * invTau * Vector2(-line._direction.y, line._direction.x);
-					_orcaLines.push_back(line);
+					orcaLines.push_back(line);
 				}
 			}
 			else {
@@ -621,7 +651,7 @@ namespace FusionCrowd
 					line._direction = -rightLegDirection;
 					line._point =
 						rightCutoff + agentInfo.radius * invTau * Vector2(-line._direction.y, line._direction.x);
-					_orcaLines.push_back(line);
+					orcaLines.push_back(line);
 				}
 			}
 		}
@@ -755,14 +785,15 @@ namespace FusionCrowd
 		}
 
 		void  PedVOComponent::LinearProgram3(const std::vector<Math::Line>& lines, size_t numObstLines,
-			size_t beginLine, float radius, float turnBias, DirectX::SimpleMath::Vector2& result)
+			size_t beginLine, float radius, float turnBias, DirectX::SimpleMath::Vector2& result,
+			std::vector<Math::Line> & projLines)
 		{
 			float distance = 0.0f;
 
 			for (size_t i = beginLine; i < lines.size(); ++i) {
 				if (Math::det(lines[i]._direction, lines[i]._point - result) > distance) {
 					/* Result does not satisfy constraint of line i. */
-					std::vector<Math::Line> projLines(lines.begin(), lines.begin() + numObstLines);
+					projLines.assign(lines.begin(), lines.begin() + numObstLines);
 
 					for (size_t j = numObstLines; j < i; ++j) {
 						Math::Line line;
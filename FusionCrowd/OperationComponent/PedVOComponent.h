@@ -7,10 +7,12 @@
 
 #include "Math/Util.h"
 #include "Math/Line.h"
+#include "Navigation/AgentSpatialInfo.h"
 
 #include "Export/ComponentId.h"
 
 #include <map>
+#include <vector>
 
 namespace FusionCrowd
 {
@@ -31,6 +33,9 @@ namespace FusionCrowd
 			float STRIDE_FACTOR;
 			float STRIDE_BUFFER;
 
+			// Right of way against each current neighbour, refilled every step
+			std::vector<float> _rightOfWay;
+
 			AgentParamentrs()
 			{
 				STRIDE_FACTOR = 1.57f;
@@ -65,8 +70,12 @@ namespace FusionCrowd
 		class PedVOComponent : public IOperationComponent
 		{
 		public:
+			// Unbounded by default so results do not change, RVO2 uses 10 to bound
+			// the number of agent lines per linear program
+			static const size_t DEFAULT_MAX_NEIGHBORS = AgentSpatialInfo::NO_NEIGHBOR_LIMIT;
+
 			PedVOComponent(std::shared_ptr<NavSystem> navSystem);
-			PedVOComponent(std::shared_ptr<NavSystem> navSystem, float cosObstTurn, float sinObstTurn);
+			PedVOComponent(std::shared_ptr<NavSystem> navSystem, float cosObstTurn, float sinObstTurn, size_t maxNeighbors = DEFAULT_MAX_NEIGHBORS);
 			~PedVOComponent();
 
 			ComponentId GetId() override { return ComponentIds::PEDVO_ID; }
@@ -74,14 +83,16 @@ namespace FusionCrowd
 			bool DeleteAgent(size_t idAgent)  override;
 			void Update(float timeStep) override;
 
-			void ComputeNewVelocity(AgentParamentrs & agentParams, AgentSpatialInfo & agentInfo, float timeStep);
+			void ComputeNewVelocity(AgentParamentrs & agentParams, AgentSpatialInfo & agentInfo, float timeStep,
+				std::vector<Math::Line> & orcaLines, std::vector<Math::Line> & projLines);
 
 			void AdaptPreferredVelocity(AgentParamentrs & agentParams, AgentSpatialInfo & agentInfo);
 			size_t ComputeORCALinesTurning(
 				AgentParamentrs & agentParams, AgentSpatialInfo & agentInfo,
 				DirectX::SimpleMath::Vector2& optVel, DirectX::SimpleMath::Vector2& prefDir, float timeStep,
-				float& prefSpeed);
-			void ObstacleLine(AgentParamentrs & agentParams, AgentSpatialInfo & agentInfo, Obstacle & obst, const float invTau, bool flip);
+				float& prefSpeed, std::vector<Math::Line> & orcaLines);
+			void ObstacleLine(AgentParamentrs & agentParams, AgentSpatialInfo & agentInfo, const Obstacle & obst, const float invTau, bool flip,
+				std::vector<Math::Line> & orcaLines);
 
 			void AddAgent(size_t agentId, float timeHorizon, float timeHorizonObst, float turningBias, bool denseAware, float factor, float buffer);
 
@@ -94,15 +105,16 @@ namespace FusionCrowd
 				DirectX::SimpleMath::Vector2& result);
 
 			void LinearProgram3(const std::vector<FusionCrowd::Math::Line>& lines, size_t numObstLines,
-				size_t beginLine, float radius, float turnBias, DirectX::SimpleMath::Vector2& result);
+				size_t beginLine, float radius, float turnBias, DirectX::SimpleMath::Vector2& result,
+				std::vector<Math::Line> & projLines);
 
 		private:
 			std::shared_ptr<NavSystem> _navSystem;
 
 			std::map<size_t, AgentParamentrs> _agents;
-			std::vector<FusionCrowd::Math::Line> _orcaLines;
 			float _cosObstTurn;
 			float _sinObstTurn;
+			size_t _maxNeighbors;
 		};
 	}
 }
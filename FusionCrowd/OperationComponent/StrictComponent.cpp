@@ -6,6 +6,7 @@
 
 #include "Navigation/AgentSpatialInfo.h"
 #include "Navigation/Obstacle.h"
+#include "OperationComponent/ParallelAgents.h"
 #include "Export/Export.h"
 
 #include <algorithm>
@@ -26,12 +27,10 @@ namespace FusionCrowd
 
 		void StrictComponent::Update(float timeStep)
 		{
-			for (auto p : _agents)
+			ParallelForAgents(*_navSystem, _agents, [this, timeStep](AgentSpatialInfo & agent, AgentParamentrs & params)
 			{
-				auto id = p.first;
-				AgentSpatialInfo & agent = _navSystem->GetSpatialInfo(id);
 				ComputeNewVelocity(agent, timeStep);
-			}
+			});
 		}
 
 		void StrictComponent::AddAgent(size_t id)
@@ -58,11 +57,11 @@ namespace FusionCrowd
 			auto neighbours = _navSystem->GetNeighbours(spatialInfo.id);
 			const float maxAcceleration = spatialInfo.maxAccel * timeStep;
 
-			AgentParamentrs & agent = _agents[spatialInfo.id];
+			AgentParamentrs & agent = _agents.at(spatialInfo.id);
 
-			float distanceToTarget = Vector2::Distance(spatialInfo.prefVelocity.getTarget(), spatialInfo.GetPos());
-			Vector2 prefVel = spatialInfo.prefVelocity.getPreferredVel();
-			Vector2 normalizedPrefVel = spatialInfo.prefVelocity.getPreferredVel();
+			float distanceToTarget = Vector2::Distance(spatialInfo.GetPrefVelocity().getTarget(), spatialInfo.GetPos());
+			Vector2 prefVel = spatialInfo.GetPrefVelocity().getPreferredVel();
+			Vector2 normalizedPrefVel = spatialInfo.GetPrefVelocity().getPreferredVel();
 			normalizedPrefVel.Normalize();
 			Vector2 orient = spatialInfo.GetOrient();
 
@@ -95,7 +94,7 @@ namespace FusionCrowd
 				speed -= maxAcceleration;
 			}
 
-			spatialInfo.velNew =Vector2(normalizedPrefVel.x * speed, normalizedPrefVel.y * speed);
+			spatialInfo.SetVelNew(Vector2(normalizedPrefVel.x * speed, normalizedPrefVel.y * speed));
 
 		}
 	}
@@ -49,7 +49,7 @@ namespace FusionCrowd
 				float acceleration = 0.0f;
 				int forwardAgtId = GetForwardAgent(agentId);
 				AgentSpatialInfo & curAgentInfo = _navSystem->GetSpatialInfo(agentId);
-				float speed = curAgentInfo.prefVelocity.getSpeed();
+				float speed = curAgentInfo.GetPrefVelocity().getSpeed();
 				float safeDist = curAgentInfo.radius * 6;
 				float angleSpeed = 45;
 
@@ -58,7 +58,7 @@ namespace FusionCrowd
 					AgentSpatialInfo & otherAgentInfo = _navSystem->GetSpatialInfo(forwardAgtId);
 
 					float d = curAgentInfo.GetPos().Distance(curAgentInfo.GetPos(), otherAgentInfo.GetPos());
-					float dv = speed - otherAgentInfo.prefVelocity.getSpeed();
+					float dv = speed - otherAgentInfo.GetPrefVelocity().getSpeed();
 					if (d > safeDist)
 					{
 						acceleration = dv * dv / (2*(d - safeDist));
@@ -68,7 +68,7 @@ namespace FusionCrowd
 					else
 					{
 						acceleration = -1 * curAgentInfo.maxAccel;
-						curAgentInfo.prefSpeed = otherAgentInfo.prefVelocity.getSpeed();
+						curAgentInfo.prefSpeed = otherAgentInfo.GetPrefVelocity().getSpeed();
 					}			
 				}
 
@@ -79,7 +79,7 @@ namespace FusionCrowd
 
 
 				Vector2 previousVel = curAgentInfo.GetVel();
-				Vector2 newVel = curAgentInfo.prefVelocity.getPreferredVel();
+				Vector2 newVel = curAgentInfo.GetPrefVelocity().getPreferredVel();
 
 				int avoidAgt = GetForwardAgentToAvoid(agentId);
 				float avoidAngle = 0.5;
@@ -91,10 +91,10 @@ namespace FusionCrowd
 					if (newVel.Length() > 1e-5)
 					{
 
-						newVel.x = curAgentInfo.prefVelocity.getPreferredVel().x * cos(avoidAngle) -
-							curAgentInfo.prefVelocity.getPreferredVel().y * sin(avoidAngle);
-						newVel.y = curAgentInfo.prefVelocity.getPreferredVel().x * sin(avoidAngle) +
-							curAgentInfo.prefVelocity.getPreferredVel().y * cos(avoidAngle);
+						newVel.x = curAgentInfo.GetPrefVelocity().getPreferredVel().x * cos(avoidAngle) -
+							curAgentInfo.GetPrefVelocity().getPreferredVel().y * sin(avoidAngle);
+						newVel.y = curAgentInfo.GetPrefVelocity().getPreferredVel().x * sin(avoidAngle) +
+							curAgentInfo.GetPrefVelocity().getPreferredVel().y * cos(avoidAngle);
 					}
 
 					acceleration = -0.3f;
@@ -112,7 +112,7 @@ namespace FusionCrowd
 
 				curAgentInfo.prefSpeed = Clamp(curAgentInfo.prefSpeed, curAgentInfo.maxSpeed);
 
-				curAgentInfo.velNew = newVel;
+				curAgentInfo.SetVelNew(newVel);
 
 				
 			}
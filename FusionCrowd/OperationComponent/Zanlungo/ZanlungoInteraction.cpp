@@ -0,0 +1,106 @@
+#include "ZanlungoInteraction.h"
+
+#include "Math/consts.h"
+#include "Math/geomQuery.h"
+
+#include <cmath>
+
+using namespace DirectX::SimpleMath;
+
+namespace FusionCrowd
+{
+	namespace Zanlungo
+	{
+		namespace
+		{
+			const float MAX_FORCE = 1e15f;
+
+			// Running minima of time to interaction. An imminent collision (ray against the
+			// minkowski sum of both disks) takes priority over approach by center projection.
+			struct TimeToInteraction
+			{
+				float T_i = Math::INFTY;
+				float t_collision = Math::INFTY;
+				bool interacts = false;
+
+				void Add(Vector2 relPos, Vector2 relVel, float circRadius)
+				{
+					const float contactT = Math::rayCircleTTC(relVel, -relPos, circRadius);
+					if (contactT < t_collision) {
+						t_collision = contactT;
+						interacts = true;
+					}
+					else if (t_collision == Math::INFTY) {
+						// relPos points from other agent to this agent, so they need to point in
+						// OPPOSITE directions for convergence
+						const float dp = -relPos.Dot(relVel);
+						if (dp > 0.f) {
+							const float t_ij = dp / relVel.LengthSquared();
+							if (t_ij < T_i) {
+								T_i = t_ij;
+								interacts = true;
+							}
+						}
+					}
+				}
+
+				bool Finish(float obstacleTTI, float timeStep, float & outTTI)
+				{
+					if (obstacleTTI < T_i) {
+						T_i = obstacleTTI;
+						interacts = true;
+					}
+					if (t_collision < Math::INFTY) T_i = t_collision;
+					if (T_i < timeStep) T_i = timeStep;
+
+					outTTI = T_i;
+					return interacts;
+				}
+			};
+
+			Vector2 PairForce(const InteractionParams & params, Vector2 futPos, Vector2 vel, float radius,
+				Vector2 otherPos, Vector2 otherVel, float otherRadius, float T_i)
+			{
+				const Vector2 otherFuturePos = otherPos + otherVel * T_i;
+				Vector2 D_ij = futPos - otherFuturePos;
+
+				// If the relative velocity is divergent do nothing
+				if (D_ij.Dot(vel - otherVel) > 0.f) return Vector2(0.f, 0.f);
+				float dist = D_ij.Length();
+				D_ij /= dist;
+
+				dist -= (radius + otherRadius);
+				float magnitude = params.agentScale * (vel - otherVel).Length() / T_i;
+				if (magnitude >= MAX_FORCE) {
+					magnitude = MAX_FORCE;
+				}
+				return D_ij * (magnitude * expf(-dist / params.forceDistance));
+			}
+		}
+
+		bool AgentInteraction(
+			const InteractionParams & params,
+			Vector2 pos, Vector2 vel, float radius,
+			Span<NeighborInfo> neighbours, float obstacleTTI, float timeStep,
+			float & outTTI, Vector2 & force)
+		{
+			TimeToInteraction tti;
+			for (const NeighborInfo & other : neighbours)
+			{
+				tti.Add(pos - other.pos, vel - other.vel, radius + other.radius);
+			}
+
+			if (!tti.Finish(obstacleTTI, timeStep, outTTI))
+				return false;
+
+			const float T_i = outTTI;
+			const Vector2 futPos = pos + vel * T_i;
+			for (const NeighborInfo & other : neighbours)
+			{
+				force += PairForce(params, futPos, vel, radius, other.pos, other.vel, other.radius, T_i);
+			}
+
+			return true;
+		}
+	}
+}
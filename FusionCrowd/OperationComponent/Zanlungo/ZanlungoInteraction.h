@@ -0,0 +1,29 @@
+#pragma once
+
+#include "Export/Config.h"
+#include "Math/Util.h"
+#include "Navigation/NeighborInfo.h"
+#include "Util/Span.h"
+
+namespace FusionCrowd
+{
+	namespace Zanlungo
+	{
+		struct InteractionParams
+		{
+			float agentScale;
+			float forceDistance;
+		};
+
+		// Finds time to interaction T_i with neighbours and obstacles (obstacleTTI is the
+		// smallest over obstacles), then adds agent-agent forces at T_i to force.
+		// Forces depend on T_i non-linearly, so the span is walked twice in place, nothing is copied.
+		// Returns false and leaves force as is if there is nothing to interact with.
+		FUSION_CROWD_API bool AgentInteraction(
+			const InteractionParams & params,
+			DirectX::SimpleMath::Vector2 pos, DirectX::SimpleMath::Vector2 vel, float radius,
+			Span<NeighborInfo> neighbours, float obstacleTTI, float timeStep,
+			float & outTTI, DirectX::SimpleMath::Vector2 & force
+		);
+	}
+}
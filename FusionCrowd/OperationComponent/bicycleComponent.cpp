@@ -6,8 +6,10 @@
 
 #include "Navigation/AgentSpatialInfo.h"
 #include "Navigation/Obstacle.h"
+#include "OperationComponent/ParallelAgents.h"
 
 #include <algorithm>
+#include <atomic>
 #include <list>
 #include <iostream>
 #include <cmath>
@@ -19,19 +21,17 @@ namespace FusionCrowd
 {
 	namespace Bicycle
 	{
-		int step = 0;
+		std::atomic<int> step(0);
 		BicycleComponent::BicycleComponent(std::shared_ptr<NavSystem> navSystem) : _navSystem(navSystem)
 		{
 		}
 
 		void BicycleComponent::Update(float timeStep)
 		{
-			for (auto p : _agents)
+			ParallelForAgents(*_navSystem, _agents, [this, timeStep](AgentSpatialInfo & agent, AgentParamentrs & params)
 			{
-				auto id = p.first;
-				AgentSpatialInfo & agent = _navSystem->GetSpatialInfo(id);
 				ComputeNewVelocity(agent, timeStep);
-			}
+			});
 		}
 
 		Vector2 rotateVector(Vector2 vector, float angle)
@@ -47,9 +47,9 @@ namespace FusionCrowd
 			std::cout << step<<"\n";
 			std::cout << "orient" << agent.GetOrient().x << ',' << agent.GetOrient().y<<"\n";
 			std::cout << "prefSpeed" << agent.prefSpeed<<"\n";
-			std::cout << "prefVel" << agent.prefVelocity.getPreferredVel().x << ',' << agent.prefVelocity.getPreferredVel().y << "\n";
+			std::cout << "prefVel" << agent.GetPrefVelocity().getPreferredVel().x << ',' << agent.GetPrefVelocity().getPreferredVel().y << "\n";
 			std::cout << "Vel" << agent.GetVel().x << ',' << agent.GetVel().y << "\n";
-			std::cout << "NewVel" << agent.velNew.x << ',' << agent.velNew.y << "\n";
+			std::cout << "NewVel" << agent.GetVelNew().x << ',' << agent.GetVelNew().y << "\n";
 		}
 
 		float BicycleComponent::CalcTargetSteeringRadius(const AgentParamentrs & agent, const AgentSpatialInfo & spatialInfo, Vector2 targetPoint)
@@ -105,14 +105,14 @@ namespace FusionCrowd
 		{
 			const float maxAcceleration = spatialInfo.maxAccel * timeStep;
 
-			AgentParamentrs & agent = _agents[spatialInfo.id];
+			AgentParamentrs & agent = _agents.at(spatialInfo.id);
 
 			//Update our length if it was changed for some reason
 			agent._length = spatialInfo.radius * 2.0f;
 			agent._theta  = atan2(spatialInfo.GetOrient().y, spatialInfo.GetOrient().x);
 
-			float distanceToTarget = Vector2::Distance(spatialInfo.prefVelocity.getTarget(), spatialInfo.GetPos());
-			Vector2 prefVel = spatialInfo.prefVelocity.getPreferredVel();
+			float distanceToTarget = Vector2::Distance(spatialInfo.GetPrefVelocity().getTarget(), spatialInfo.GetPos());
+			Vector2 prefVel = spatialInfo.GetPrefVelocity().getPreferredVel();
 			Vector2 normalizedPrefVel; prefVel.Normalize(normalizedPrefVel);
 			Vector2 orient = spatialInfo.GetOrient();
 
@@ -132,10 +132,10 @@ namespace FusionCrowd
 				currentSteeringR = agent._length / cos(Math::PI / 2.0f - abs(agent._delta));
 			}
 
-			float targetSteeringR = CalcTargetSteeringRadius(agent, spatialInfo, spatialInfo.prefVelocity.getTarget());
+			float targetSteeringR = CalcTargetSteeringRadius(agent, spatialInfo, spatialInfo.GetPrefVelocity().getTarget());
 
 			float speed = vel.Length();
-			float adjustedPreferredSpeed = GetAdjustedPreferredSpeed(spatialInfo.prefVelocity.getSpeed(), distanceToTarget);
+			float adjustedPreferredSpeed = GetAdjustedPreferredSpeed(spatialInfo.GetPrefVelocity().getSpeed(), distanceToTarget);
 			float accelerationToPref = adjustedPreferredSpeed - speed;
 
 			bool sameSide = Math::sgn(angleToTarget) == Math::sgn(agent._delta);
@@ -164,8 +164,8 @@ namespace FusionCrowd
 				if (obst.distanceSqToPoint(agent.pos, nearPt, sqDist) == Obstacle::LAST) continue;
 				if (SAFE_DIST2 > sqDist)
 				{
-					_agents[agent.id]._delta = 0.0f;
-					_agents[agent.id]._theta = atan2(normalizedPrefVel.y, normalizedPrefVel.x);
+					_agents.at(agent.id)._delta = 0.0f;
+					_agents.at(agent.id)._theta = atan2(normalizedPrefVel.y, normalizedPrefVel.x);
 				}
 			}
 			*/
@@ -189,7 +189,7 @@ namespace FusionCrowd
 			// rotate virtual bike body
 			agent._theta += speed * tan(agent._delta) / agent._length;
 
-			spatialInfo.velNew = speed * Vector2(cos(agent._theta), sin(agent._theta));
+			spatialInfo.SetVelNew(speed * Vector2(cos(agent._theta), sin(agent._theta)));
 
 			step++;
 		}
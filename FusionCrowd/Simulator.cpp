@@ -5,6 +5,7 @@
 #include "Navigation/NavSystem.h"
 #include "Navigation/AgentSpatialInfo.h"
 #include "TacticComponent/NavMesh/NavMeshComponent.h"
+#include "OperationComponent/GCFComponent.h"
 #include "StrategyComponent/Goal/Goal.h"
 #include "Navigation/OnlineRecording/OnlineRecording.h"
 #include "Group/GridGroup.h"
@@ -23,7 +24,7 @@ namespace FusionCrowd
 	class Simulator::SimulatorImpl
 	{
 	public:
-		SimulatorImpl()
+		SimulatorImpl() : _scheduler(std::make_shared<TaskScheduler>(0))
 		{
 			_recording = OnlineRecording();
 		}
@@ -198,6 +199,83 @@ namespace FusionCrowd
 			return true;
 		}
 
+		bool UpdateMaxNeighbors(size_t agentId, size_t maxNeighbors)
+		{
+			auto agentIt = _agents.find(agentId);
+			if(agentIt == _agents.end())
+				return false;
+
+			agentIt->second.hasMaxNeighbors = true;
+			agentIt->second.maxNeighbors = maxNeighbors;
+			_navSystem->GetSpatialInfo(agentId).maxNeighbors = maxNeighbors;
+
+			return true;
+		}
+
+		std::shared_ptr<NavMeshComponent> GetNavMeshTactic() const
+		{
+			auto tactic = _tacticComponents.find(ComponentIds::NAVMESH_ID);
+			if(tactic == _tacticComponents.end())
+				return nullptr;
+
+			return std::static_pointer_cast<NavMeshComponent>(tactic->second);
+		}
+
+		void SetReplanBudget(size_t microseconds)
+		{
+			auto navMesh = GetNavMeshTactic();
+			if(navMesh != nullptr)
+				navMesh->SetReplanBudget(microseconds);
+		}
+
+		ReplanQueueStats GetReplanQueueStats() const
+		{
+			auto navMesh = GetNavMeshTactic();
+			if(navMesh == nullptr)
+				return ReplanQueueStats {};
+
+			return navMesh->GetReplanQueueStats();
+		}
+
+		float GetAgentPlanWait(size_t agentId) const
+		{
+			auto navMesh = GetNavMeshTactic();
+			if(navMesh == nullptr)
+				return 0.f;
+
+			return navMesh->GetPlanWait(agentId);
+		}
+
+		void SetRouteCacheBudget(size_t bytes)
+		{
+			auto navMesh = GetNavMeshTactic();
+			if(navMesh != nullptr)
+				navMesh->SetRouteCacheBudget(bytes);
+		}
+
+		RouteCacheStats GetRouteCacheStats() const
+		{
+			auto navMesh = GetNavMeshTactic();
+			if(navMesh == nullptr)
+				return RouteCacheStats {};
+
+			return navMesh->GetRouteCacheStats();
+		}
+
+		bool SetGcfDistanceAccuracy(float absoluteError, float relativeError)
+		{
+			auto op = _operComponents.find(ComponentIds::GCF_ID);
+			if(op == _operComponents.end())
+				return false;
+
+			GCF::DistanceAccuracy accuracy;
+			accuracy.absoluteError = absoluteError;
+			accuracy.relativeError = relativeError;
+			std::static_pointer_cast<GCF::GCFComponent>(op->second)->SetDistanceAccuracy(accuracy);
+
+			return true;
+		}
+
 		OperationStatus RemoveGroup(size_t groupId) {
 
 			if (_groups.find(groupId) == _groups.end())
@@ -333,9 +411,25 @@ namespace FusionCrowd
 		void SetNavSystem(std::shared_ptr<NavSystem> navSystem)
 		{
 			_navSystem = navSystem;
+			_navSystem->SetScheduler(_scheduler);
 			_navSystem->Init();
 		}
 
+		void SetThreadCount(size_t threadCount)
+		{
+			_scheduler->SetThreadCount(threadCount);
+		}
+
+		size_t GetThreadCount() const
+		{
+			return _scheduler->GetThreadCount();
+		}
+
+		TaskScheduler & GetScheduler() const
+		{
+			return *_scheduler;
+		}
+
 		Agent & GetAgent(size_t id)
 		{
 			return _agents.find(id)->second;
@@ -441,7 +535,7 @@ namespace FusionCrowd
 		{
 			size_t grpId = _nextGroupId++;
 
-			auto & leaderInfo = _navSystem->GetSpatialInfo(leaderId);
+			const Vector2 leaderPos = _navSystem->GetSpatialInfo(leaderId).GetPos();
 
 			AgentSpatialInfo dummyInfo;
 			dummyInfo.collisionsLevel = AgentSpatialInfo::GROUP;
@@ -450,10 +544,12 @@ namespace FusionCrowd
 			dummyInfo.maxSpeed  /= 2.0f;
 			dummyInfo.maxAngVel = 50.5f;
 			dummyInfo.inertiaEnabled = false;
-			dummyInfo.SetPos(leaderInfo.GetPos());
+			dummyInfo.SetPos(leaderPos);
 
 			size_t dummyId = AddAgent(std::move(dummyInfo), GetAnyOperational(), GetAnyTactic(), ComponentIds::NO_COMPONENT);
 
+			// Agent storage is dense, references taken before AddAgent may be invalidated
+			auto & leaderInfo = _navSystem->GetSpatialInfo(leaderId);
 			_groups[grpId] = std::make_unique<GuidedGroup>(grpId, dummyId, leaderInfo);
 
 			AddAgentToGroup(leaderId, grpId);
@@ -547,8 +643,13 @@ namespace FusionCrowd
 					}
 				}
 
+				// Neighbour cap belongs to the model, the new one sets its own if it needs it
+				_navSystem->GetSpatialInfo(agentId).maxNeighbors = AgentSpatialInfo::NO_NEIGHBOR_LIMIT;
 				newOperationComponent->second->AddAgent(agentId);
 				agent.opComponent = newOperationComponent->second;
+
+				if(agent.hasMaxNeighbors)
+					_navSystem->GetSpatialInfo(agentId).maxNeighbors = agent.maxNeighbors;
 			}
 
 			_switchComponentTasks.clear();
@@ -574,6 +675,7 @@ namespace FusionCrowd
 
 		float _currentTime = 0;
 
+		std::shared_ptr<TaskScheduler> _scheduler;
 		std::shared_ptr<NavSystem> _navSystem;
 		OnlineRecording _recording;
 		bool _isRecording = false;
@@ -672,6 +774,21 @@ namespace FusionCrowd
 		return *this;
 	}
 
+	void Simulator::SetThreadCount(size_t threadCount)
+	{
+		pimpl->SetThreadCount(threadCount);
+	}
+
+	size_t Simulator::GetThreadCount() const
+	{
+		return pimpl->GetThreadCount();
+	}
+
+	TaskScheduler & Simulator::GetScheduler() const
+	{
+		return pimpl->GetScheduler();
+	}
+
 	Agent & Simulator::GetAgent(size_t id)
 	{
 		return pimpl->GetAgent(id);
@@ -709,6 +826,41 @@ namespace FusionCrowd
 		return pimpl->UpdateNeighbourSearchShape(agentId, disk);
 	}
 
+	bool Simulator::UpdateMaxNeighbors(size_t agentId, size_t maxNeighbors)
+	{
+		return pimpl->UpdateMaxNeighbors(agentId, maxNeighbors);
+	}
+
+	void Simulator::SetReplanBudget(size_t microseconds)
+	{
+		pimpl->SetReplanBudget(microseconds);
+	}
+
+	ReplanQueueStats Simulator::GetReplanQueueStats() const
+	{
+		return pimpl->GetReplanQueueStats();
+	}
+
+	float Simulator::GetAgentPlanWait(size_t agentId) const
+	{
+		return pimpl->GetAgentPlanWait(agentId);
+	}
+
+	void Simulator::SetRouteCacheBudget(size_t bytes)
+	{
+		pimpl->SetRouteCacheBudget(bytes);
+	}
+
+	RouteCacheStats Simulator::GetRouteCacheStats() const
+	{
+		return pimpl->GetRouteCacheStats();
+	}
+
+	bool Simulator::SetGcfDistanceAccuracy(float absoluteError, float relativeError)
+	{
+		return pimpl->SetGcfDistanceAccuracy(absoluteError, relativeError);
+	}
+
 	size_t Simulator::AddAgent(AgentSpatialInfo props, ComponentId opId, ComponentId tacticId, ComponentId strategyId)
 	{
 		return pimpl->AddAgent(std::move(props), opId, tacticId, strategyId);
@@ -16,6 +16,7 @@
 #include "Navigation/NavSystem.h"
 
 #include "Util/spimpl.h"
+#include "Util/TaskScheduler.h"
 #include "Math/Util.h"
 
 #include "Group/IGroup.h"
@@ -36,6 +37,11 @@ namespace FusionCrowd
 		Simulator & AddStrategy(std::shared_ptr<IStrategyComponent> strategyComponent);
 		Simulator & UseNavSystem(std::shared_ptr<NavSystem> system);
 
+		// Threads of the scheduler shared by NavSystem and components, 0 means hardware concurrency
+		void SetThreadCount(size_t threadCount);
+		size_t GetThreadCount() const;
+		TaskScheduler & GetScheduler() const;
+
 		bool DoStep(float timeStep);
 
 		bool SetOperationComponent(size_t agentId, ComponentId newOperationComponent);
@@ -58,6 +64,14 @@ namespace FusionCrowd
 		bool UpdateAgentParams(AgentParams params);
 		bool UpdateNeighbourSearchShape(size_t agentId, Cone cone);
 		bool UpdateNeighbourSearchShape(size_t agentId, Disk disk);
+		bool UpdateMaxNeighbors(size_t agentId, size_t maxNeighbors);
+
+		void SetReplanBudget(size_t microseconds);
+		ReplanQueueStats GetReplanQueueStats() const;
+		float GetAgentPlanWait(size_t agentId) const;
+		void SetRouteCacheBudget(size_t bytes);
+		RouteCacheStats GetRouteCacheStats() const;
+		bool SetGcfDistanceAccuracy(float absoluteError, float relativeError);
 		OperationStatus UpdateSpecialOpParams(size_t agentId, StrictOCParams params);
 
 		OperationStatus RemoveAgent(size_t agentId);
@@ -31,8 +31,8 @@ namespace FusionCrowd
 			AgentSpatialInfo & info = _simulator->GetSpatialInfo(id);
 			Vector2 dir = agtStruct.second.input;
 			if (dir.Length() > 0) dir /= dir.Length();
-			info.prefVelocity.setSingle(dir);
-			info.prefVelocity.setSpeed(10.0f);
+			info.GetPrefVelocity().setSingle(dir);
+			info.GetPrefVelocity().setSpeed(10.0f);
 			agtStruct.second.input = Vector2(0, 0);
 		}
 	}
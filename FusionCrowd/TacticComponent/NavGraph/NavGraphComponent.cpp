@@ -58,7 +58,7 @@ namespace FusionCrowd
 				auto grp = _simulator->GetGroup(groupId);
 				auto & dummy = _simulator->GetSpatialInfo(grp->GetDummyId());
 				if (grp == nullptr) {
-					info.prefVelocity.setSpeed(0);
+					info.GetPrefVelocity().setSpeed(0);
 					continue;
 				}
 
@@ -95,18 +95,18 @@ namespace FusionCrowd
 
 		if(dist < agentInfo.prefSpeed * timeStep)
 		{
-			agentInfo.prefVelocity.setSpeed(dist);
+			agentInfo.GetPrefVelocity().setSpeed(dist);
 		} else
 		{
-			agentInfo.prefVelocity.setSpeed(agentInfo.prefSpeed);
+			agentInfo.GetPrefVelocity().setSpeed(agentInfo.prefSpeed);
 		}
 
 		if (abs(dist) > 1e-6)
 		{
-			agentInfo.prefVelocity.setSingle((currentGoal + shift - agentInfo.GetPos()) / dist);
+			agentInfo.GetPrefVelocity().setSingle((currentGoal + shift - agentInfo.GetPos()) / dist);
 		} else
 		{
-			agentInfo.prefVelocity.setSpeed(0);
+			agentInfo.GetPrefVelocity().setSpeed(0);
 		}
 
 		TrafficLightsBunch* curLights = _navSystem->GetTrafficLights(_navGraph->GetClosestNodeIdByPosition(currentGoal, _navGraph->GetAllNodes()));
@@ -116,11 +116,11 @@ namespace FusionCrowd
 				curLights->GetProperLight(agentInfo.GetOrient())->GetCurLight() == TrafficLight::Lights::yellow) &&
 				dist < agentInfo.radius * 15 && dist > agentInfo.radius * 12)
 			{
-				agentInfo.prefVelocity.setSpeed(1e-6);
+				agentInfo.GetPrefVelocity().setSpeed(1e-6);
 			}
 		}
 
-		agentInfo.prefVelocity.setTarget(currentGoal+shift);
+		agentInfo.GetPrefVelocity().setTarget(currentGoal+shift);
 	}
 
 	DirectX::SimpleMath::Vector2 NavGraphComponent::GetClosestAvailablePoint(DirectX::SimpleMath::Vector2 p)
@@ -8,8 +8,14 @@
 #include "StrategyComponent/Goal/Goal.h"
 #include "TacticComponent/PrefVelocity.h"
 #include "Math/consts.h"
+#include "Util/TaskScheduler.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <iostream>
+#include <map>
+#include <tuple>
 
 using namespace DirectX::SimpleMath;
 
@@ -21,14 +27,33 @@ namespace FusionCrowd
 	{
 	}
 
-	NavMeshLocation NavMeshComponent::Replan(Vector2 fromPoint, const Goal & target, float agentRadius)
+	namespace
+	{
+		const float WIDTH_CLASS_STEP = 0.01f;
+
+		// Replanning requests served between budget checks
+		const size_t REPLAN_BATCH = 256;
+	}
+
+	float NavMeshComponent::WidthClass(float agentRadius)
+	{
+		// Rounded up, so the route is wide enough for every agent of the class
+		return std::ceil(agentRadius / WIDTH_CLASS_STEP - 1e-3f) * WIDTH_CLASS_STEP;
+	}
+
+	unsigned int NavMeshComponent::PathSeed(size_t agentId, size_t ticket)
+	{
+		return (unsigned int) (agentId * 2654435761u + ticket);
+	}
+
+	NavMeshLocation NavMeshComponent::Replan(Vector2 fromPoint, const Goal & target, float agentRadius, unsigned int seed)
 	{
 		size_t from = GetClosestAvailableNode(fromPoint);
 		size_t to = GetClosestAvailableNode(target.getCentroid());
 
 		auto planner = _localizer->getPlanner();
-		auto* route = planner->getRoute(from, to, agentRadius);
-		std::shared_ptr<PortalPath> path = std::make_shared<PortalPath>(fromPoint, target, route, agentRadius);
+		auto route = planner->getRoute(from, to, WidthClass(agentRadius));
+		std::shared_ptr<PortalPath> path = std::make_shared<PortalPath>(fromPoint, target, route, agentRadius, seed);
 
 		NavMeshLocation location(from);
 		location.setPath(path);
@@ -36,6 +61,71 @@ namespace FusionCrowd
 		return location;
 	}
 
+	void NavMeshComponent::ReplanBatch(const std::vector<size_t> & agentIdxs)
+	{
+		const size_t count = agentIdxs.size();
+		if (count == 0)
+			return;
+
+		TaskScheduler & scheduler = _simulator->GetScheduler();
+
+		std::vector<unsigned int> from(count), to(count);
+		std::vector<float> width(count);
+		scheduler.ParallelFor(count, [&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				const size_t id = _agents[agentIdxs[i]].id;
+				const AgentSpatialInfo & info = _simulator->GetSpatialInfo(id);
+
+				from[i] = GetClosestAvailableNode(info.GetPos());
+				to[i] = GetClosestAvailableNode(_simulator->GetAgentGoal(id).getCentroid());
+				width[i] = WidthClass(info.radius);
+			}
+		}, 16);
+
+		typedef std::tuple<unsigned int, unsigned int, float> RequestKey;
+		std::map<RequestKey, size_t> requestIdx;
+		std::vector<RequestKey> requests;
+		std::vector<size_t> agentRequest(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			const RequestKey key(from[i], to[i], width[i]);
+			auto inserted = requestIdx.insert(std::make_pair(key, requests.size()));
+			if (inserted.second)
+				requests.push_back(key);
+
+			agentRequest[i] = inserted.first->second;
+		}
+
+		auto planner = _localizer->getPlanner();
+		std::vector<PortalRoutePtr> routes(requests.size());
+		scheduler.ParallelFor(requests.size(), [&](size_t begin, size_t end)
+		{
+			for (size_t r = begin; r < end; r++)
+			{
+				routes[r] = planner->getRoute(std::get<0>(requests[r]), std::get<1>(requests[r]), std::get<2>(requests[r]));
+			}
+		});
+
+		scheduler.ParallelFor(count, [&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				AgentStruct & agtStruct = _agents[agentIdxs[i]];
+				const AgentSpatialInfo & info = _simulator->GetSpatialInfo(agtStruct.id);
+
+				NavMeshLocation location(from[i]);
+				location.setPath(std::make_shared<PortalPath>(
+					info.GetPos(), _simulator->GetAgentGoal(agtStruct.id), routes[agentRequest[i]], info.radius,
+					PathSeed(agtStruct.id, agtStruct.ticket)
+				));
+				agtStruct.location = location;
+				agtStruct.waiting = false;
+			}
+		}, 16);
+	}
+
 	void NavMeshComponent::AddAgent(size_t id)
 	{
 		auto & agentGoal = _simulator->GetAgentGoal(id);
@@ -44,24 +134,112 @@ namespace FusionCrowd
 
 		AgentStruct agtStruct;
 		agtStruct.id = id;
-		agtStruct.location = Replan(agentInfo.GetPos(), agentGoal, agentInfo.radius);
+		agtStruct.ticket = _nextTicket++;
+		agtStruct.location = Replan(agentInfo.GetPos(), agentGoal, agentInfo.radius, PathSeed(id, agtStruct.ticket));
 
+		_agentIdx[id] = _agents.size();
 		_agents.push_back(agtStruct);
 	}
 
 	bool NavMeshComponent::DeleteAgent(size_t id)
 	{
-		for (int i = 0; i < _agents.size(); i++) {
-			if (_agents[i].id == id) {
-				_agents.erase(_agents.begin() + i);
-				break;
-			}
+		auto it = _agentIdx.find(id);
+		if (it != _agentIdx.end()) {
+			const size_t idx = it->second;
+			_agents.erase(_agents.begin() + idx);
+			_agentIdx.erase(it);
+
+			for (size_t i = idx; i < _agents.size(); i++)
+				_agentIdx[_agents[i].id] = i;
 		}
 		return false;
 	}
 
+	float NavMeshComponent::GetPlanWait(size_t agentId) const
+	{
+		auto it = _agentIdx.find(agentId);
+		if (it == _agentIdx.end())
+			return 0.f;
+
+		return _agents[it->second].planWait;
+	}
+
+	void NavMeshComponent::SetRouteCacheBudget(size_t bytes)
+	{
+		_localizer->getPlanner()->SetCacheBudget(bytes);
+	}
+
+	RouteCacheStats NavMeshComponent::GetRouteCacheStats() const
+	{
+		return _localizer->getPlanner()->GetCacheStats();
+	}
+
+	void NavMeshComponent::ServeReplanQueue()
+	{
+		using namespace std::chrono;
+
+		std::sort(_replans.begin(), _replans.end(), [this](size_t a, size_t b)
+		{
+			return _agents[a].ticket < _agents[b].ticket;
+		});
+
+		const auto start = steady_clock::now();
+		const size_t batch = _replanBudget == 0 ? _replans.size() : REPLAN_BATCH;
+
+		size_t served = 0;
+		while (served < _replans.size())
+		{
+			const size_t end = std::min(served + batch, _replans.size());
+			ReplanBatch(std::vector<size_t>(_replans.begin() + served, _replans.begin() + end));
+			served = end;
+
+			if (_replanBudget > 0 && duration_cast<microseconds>(steady_clock::now() - start).count() >= (long long) _replanBudget)
+				break;
+		}
+
+		_replanStats = ReplanQueueStats {};
+		_replanStats.queueLength = _replans.size() - served;
+		_replanStats.planned = served;
+		for (size_t i = 0; i < served; i++)
+		{
+			const float wait = _agents[_replans[i]].planWait;
+			_replanStats.meanWait += wait;
+			_replanStats.maxWait = std::max(_replanStats.maxWait, wait);
+		}
+		if (served > 0)
+			_replanStats.meanWait /= served;
+	}
+
 	void NavMeshComponent::Update(float timeStep)
 	{
+		_replans.clear();
+		for (size_t i = 0; i < _agents.size(); i++)
+		{
+			AgentStruct & agtStruct = _agents[i];
+			if (_simulator->GetAgent(agtStruct.id).GetGroupId() != IGroup::NO_GROUP)
+				continue;
+
+			if (agtStruct.waiting)
+			{
+				agtStruct.planWait += timeStep;
+			}
+			else if (IsReplanNeeded(_simulator->GetSpatialInfo(agtStruct.id), agtStruct))
+			{
+				// The old path leads to another goal or through a changed mesh
+				agtStruct.location.clearPath();
+				agtStruct.waiting = true;
+				agtStruct.ticket = _nextTicket++;
+				agtStruct.planWait = 0.f;
+			}
+			else
+			{
+				continue;
+			}
+
+			_replans.push_back(i);
+		}
+		ServeReplanQueue();
+
 		for (auto & agtStruct : _agents)
 		{
 			size_t id = agtStruct.id;
@@ -74,7 +252,7 @@ namespace FusionCrowd
 				auto grp = _simulator->GetGroup(groupId);
 				auto & dummy = _simulator->GetSpatialInfo(grp->GetDummyId());
 				if (grp == nullptr) {
-					info.prefVelocity.setSpeed(0);
+					info.GetPrefVelocity().setSpeed(0);
 					continue;
 				}
 
@@ -82,12 +260,6 @@ namespace FusionCrowd
 				continue;
 			}
 
-			if(IsReplanNeeded(info, agtStruct))
-			{
-				auto & curGoal = _simulator->GetAgentGoal(info.id);
-				agtStruct.location = Replan(info.GetPos(), curGoal, info.radius);
-			}
-
 			UpdateLocation(info, agtStruct, false);
 			SetPrefVelocity(info, agtStruct, timeStep);
 		}
@@ -106,23 +278,9 @@ namespace FusionCrowd
 			return correct;
 		}
 
-		float min_dist = INFINITY;
-		size_t res;
-		auto navMesh = _localizer->getNavMesh();
-		for (size_t i = 0; i < navMesh->getNodeCount(); i++)
-		{
-			const auto & node = navMesh->GetNodeByPos(i);
-			if (!node.deleted)
-			{
-				Vector2 center = node.getCenter();
-				if ((p - center).LengthSquared() < min_dist)
-				{
-					min_dist = (p - center).LengthSquared();
-					res = i;
-				}
-			}
-		}
-		if (min_dist == INFINITY)
+		Vector2 closest;
+		unsigned int res;
+		if (!_localizer->FindClosestBoundaryPoint(p, closest, res))
 		{
 			throw 1;
 		}
@@ -137,7 +295,7 @@ namespace FusionCrowd
 		return
 			path == nullptr ||
 			path->getGoal().getID() != agentGoal.getID() ||
-			!path->IsValid(_navMesh->GetVersion());
+			!path->IsValid(*_navMesh);
 	}
 
 	void NavMeshComponent::SetPrefVelocity(AgentSpatialInfo & agentInfo, AgentStruct & agentStruct, float timeStep)
@@ -147,13 +305,34 @@ namespace FusionCrowd
 
 		if (agentGoal.getGeometry()->containsPoint(agentInfo.GetPos()))
 		{
-			agentInfo.prefVelocity.setSpeed(0);
+			agentInfo.GetPrefVelocity().setSpeed(0);
+			return;
+		}
+
+		if (agentStruct.waiting)
+		{
+			SteerToGoal(agentInfo, agentGoal, timeStep);
 			return;
 		}
 
 		path->setPrefVelocity(agentInfo, _headingDevCos, timeStep);
 	}
 
+	void NavMeshComponent::SteerToGoal(AgentSpatialInfo & agentInfo, const Goal & goal, float timeStep) const
+	{
+		goal.setDirections(agentInfo.GetPos(), agentInfo.radius, agentInfo.GetPrefVelocity());
+
+		float speed = agentInfo.prefSpeed;
+		Vector2 goalPoint = goal.getGeometry()->getTargetPoint(agentInfo.GetPos(), agentInfo.radius);
+		const float distSq = (goalPoint - agentInfo.GetPos()).LengthSquared();
+		if (distSq < speed * speed * timeStep * timeStep)
+		{
+			// Goal is closer than a single step
+			speed = sqrtf(distSq) / timeStep;
+		}
+		agentInfo.GetPrefVelocity().setSpeed(speed);
+	}
+
 	unsigned int NavMeshComponent::UpdateLocation(AgentSpatialInfo & agentInfo, AgentStruct& agentStruct, bool force) const
 	{
 		NavMeshLocation & loc = agentStruct.location;
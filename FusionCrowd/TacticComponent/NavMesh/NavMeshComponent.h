@@ -1,5 +1,6 @@
 #pragma once
 
+#include <map>
 #include <string>
 
 #include "Export/ComponentId.h"
@@ -8,6 +9,7 @@
 #include "Navigation/NavMesh/NavMesh.h"
 #include "Navigation/NavMesh/NavMeshLocalizer.h"
 #include "Navigation/SpatialQuery/NavMeshSpatialQuery.h"
+#include "Export/Export.h"
 #include "Simulator.h"
 
 namespace FusionCrowd
@@ -37,18 +39,45 @@ namespace FusionCrowd
 
 		ComponentId GetId() override { return ComponentIds::NAVMESH_ID; }
 
+		// Replanning is queued and served in arrival order until the step has spent
+		// budget microseconds on it, at least one batch per step. 0 serves the whole queue.
+		void SetReplanBudget(size_t microseconds) { _replanBudget = microseconds; }
+		size_t GetReplanBudget() const { return _replanBudget; }
+		const ReplanQueueStats & GetReplanQueueStats() const { return _replanStats; }
+		float GetPlanWait(size_t agentId) const;
+
+		void SetRouteCacheBudget(size_t bytes);
+		RouteCacheStats GetRouteCacheStats() const;
+
 	private:
 		struct AgentStruct
 		{
 		public:
 			unsigned int id;
 			NavMeshLocation location;
+
+			bool waiting = false;
+			// Arrival order in the replanning queue
+			size_t ticket = 0;
+			float planWait = 0.f;
 		};
 
-		NavMeshLocation Replan(DirectX::SimpleMath::Vector2 from, const Goal & target, float agentRadius);
+		// Agents with radii in the same class share planned routes
+		static float WidthClass(float agentRadius);
+
+		// Seed of the waypoint randomisation, the same for the same agent and request on any thread
+		static unsigned int PathSeed(size_t agentId, size_t ticket);
+
+		NavMeshLocation Replan(DirectX::SimpleMath::Vector2 from, const Goal & target, float agentRadius, unsigned int seed);
+		// Plans routes for _agents[i] of all given i in parallel, one route per distinct
+		// (start node, goal node, width class)
+		void ReplanBatch(const std::vector<size_t> & agentIdxs);
 		bool IsReplanNeeded(AgentSpatialInfo & agentInfo, AgentStruct & agentStruct);
 
+		void ServeReplanQueue();
+
 		void SetPrefVelocity(AgentSpatialInfo & agentInfo, AgentStruct & agentStruct, float timeStep);
+		void SteerToGoal(AgentSpatialInfo & agentInfo, const Goal & goal, float timeStep) const;
 		unsigned int UpdateLocation(AgentSpatialInfo & agentInfo, AgentStruct& agentStruct, bool force) const;
 
 	private:
@@ -59,6 +88,13 @@ namespace FusionCrowd
 		std::shared_ptr<NavMeshLocalizer> _localizer;
 		std::shared_ptr<NavMeshSpatialQuery> _spatial_query;
 		std::vector<AgentStruct> _agents;
+		// Agent id to its index in _agents
+		std::map<size_t, size_t> _agentIdx;
+		std::vector<size_t> _replans;
+
+		size_t _replanBudget = 0;
+		size_t _nextTicket = 0;
+		ReplanQueueStats _replanStats {};
 	};
 }
 
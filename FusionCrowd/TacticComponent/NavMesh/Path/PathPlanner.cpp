@@ -5,19 +5,53 @@
 #include "Navigation/NavMesh/NavMesh.h"
 #include "Navigation/NavMesh/NavMeshNode.h"
 
+#include <algorithm>
 #include <iostream>
 #include <cassert>
+#include <memory>
+#include <mutex>
 #include <sstream>
+#include <vector>
 #include "Navigation/NavMesh/NavMeshLocalizer.h"
 
-#ifdef _OPENMP
-#include <omp.h>
-#endif
-
 using namespace DirectX::SimpleMath;
 
 namespace FusionCrowd
 {
+	namespace
+	{
+		// A* memory of one thread, grown to the largest navmesh it has planned on
+		struct AStarScratch
+		{
+			size_t nodeCount = 0;
+			std::unique_ptr<unsigned int[]> heap;
+			std::unique_ptr<unsigned int[]> path;
+			std::unique_ptr<float[]> data;
+			std::unique_ptr<bool[]> state;
+
+			void Reserve(size_t N)
+			{
+				if (N <= nodeCount)
+					return;
+
+				heap.reset(new unsigned int[N]);
+				path.reset(new unsigned int[N]);
+				data.reset(new float[3 * N]);
+				state.reset(new bool[2 * N]);
+				nodeCount = N;
+			}
+		};
+
+		thread_local AStarScratch scratch;
+
+		// Approximate heap footprint of a cached route, list node included
+		size_t RouteBytes(const PortalRoute & route)
+		{
+			return sizeof(PortalRoute) + sizeof(CachedRoute) + 2 * sizeof(void*)
+				+ route.getPortalCount() * sizeof(WayPortal);
+		}
+	}
+
 	RouteKey makeRouteKey(unsigned int start, unsigned int end)
 	{
 		const int SHIFT = sizeof(size_t) * 4; // size in bytes * 8 bits/byte / 2
@@ -27,68 +61,102 @@ namespace FusionCrowd
 		return ((size_t)start << SHIFT) | ((size_t)end & MASK);
 	}
 
-	PathPlanner::PathPlanner(std::shared_ptr<NavMesh> ptr) : _navMesh(ptr), DATA_SIZE(0), STATE_SIZE(0),
-	                                           _HEAP(0x0), _DATA(0x0), _STATE(0x0)
+	const size_t PathPlanner::ROUTE_SHARDS;
+
+	PathPlanner::PathPlanner(std::shared_ptr<NavMesh> ptr, size_t cacheBudget) :
+		_navMesh(ptr), _budget(cacheBudget), _useClock(0),
+		_hits(0), _misses(0), _evictions(0), _bytes(0), _count(0)
 	{
-		size_t nCount = _navMesh->getNodeCount();
-		initHeapMemory(nCount);
 	}
 
 
 	PathPlanner::~PathPlanner()
 	{
-		initHeapMemory(0);
 	}
 
-	PortalRoute* PathPlanner::getRoute(unsigned int startID, unsigned int endID,
-	                                   float minWidth)
+	PathPlanner::RouteShard & PathPlanner::getShard(RouteKey key)
+	{
+		return _shards[std::hash<RouteKey>()(key) % ROUTE_SHARDS];
+	}
+
+	CachedRoute* PathPlanner::findRoute(PRouteList & routes, float minWidth) const
+	{
+		CachedRoute* route = NULL;
+		// test the routes to see if they are passable
+		for (PRouteListItr rItr = routes.begin(); rItr != routes.end(); ++rItr)
+		{
+			if (rItr->route->_maxWidth > minWidth && rItr->route->IsValid(*_navMesh))
+			{
+				if (rItr->route->_bestSmallest <= minWidth * 1.05f)
+				{
+					route = &(*rItr);
+				}
+			}
+		}
+		return route;
+	}
+
+	PortalRoutePtr PathPlanner::getRoute(unsigned int startID, unsigned int endID,
+	                                     float minWidth)
 	{
 		RouteKey key = makeRouteKey(startID, endID);
+		RouteShard & shard = getShard(key);
 
-		PortalRoute* route = NULL;
-		//_routeLock.lockRead();
-		PRouteMapItr itr = _routes.find(key);
-		if (itr != _routes.end())
+		PortalRoutePtr route;
 		{
-			// test the routes to see if they are passable
-			PRouteListItr rItr = itr->second.begin();
-			for (; rItr != itr->second.end(); ++rItr)
+			std::shared_lock<std::shared_timed_mutex> lock(shard.lock);
+			PRouteMapItr itr = shard.routes.find(key);
+			if (itr != shard.routes.end())
 			{
-				if ((*rItr)->_maxWidth > minWidth)
+				if (CachedRoute* cached = findRoute(itr->second, minWidth))
 				{
-					if ((*rItr)->_bestSmallest <= minWidth * 1.05f)
-					{
-						route = *rItr;
-					}
+					cached->lastUse.store(++_useClock, std::memory_order_relaxed);
+					route = cached->route;
 				}
 			}
 		}
-		//_routeLock.releaseRead();
 
 		// Compute a new path
-		if (route == 0x0)
+		if (route == nullptr)
 		{
+			++_misses;
 			return computeRoute(startID, endID, minWidth);
 		}
 		else
 		{
+			++_hits;
 			return route;
 		}
 	}
 
-	PortalRoute* PathPlanner::computeRoute(unsigned int startID, unsigned int endID
+	void PathPlanner::SetCacheBudget(size_t bytes)
+	{
+		_budget = bytes;
+		for (RouteShard & shard : _shards)
+		{
+			std::unique_lock<std::shared_timed_mutex> lock(shard.lock);
+			evict(shard, bytes / ROUTE_SHARDS);
+		}
+	}
+
+	RouteCacheStats PathPlanner::GetCacheStats() const
+	{
+		RouteCacheStats stats;
+		stats.hits = _hits;
+		stats.misses = _misses;
+		stats.evictions = _evictions;
+		stats.routes = _count;
+		stats.bytesUsed = _bytes;
+		stats.byteBudget = _budget;
+		return stats;
+	}
+
+	PortalRoutePtr PathPlanner::computeRoute(unsigned int startID, unsigned int endID
 	                                       , float minWidth)
 	{
 		const size_t N = _navMesh->getNodeCount();
-#ifdef _OPENMP
-	// Assuming that threadNum \in [0, omp_get_max_threads() )
-	const unsigned int threadNum = omp_get_thread_num();
-	AStarMinHeap heap(_HEAP + threadNum * N, _DATA + threadNum * DATA_SIZE,
-		_STATE + threadNum * STATE_SIZE, _PATH + threadNum * N, N);
-#else
-
-		AStarMinHeap heap(_HEAP, _DATA, _STATE, _PATH, N);
-#endif
+		scratch.Reserve(N);
+		AStarMinHeap heap(scratch.heap.get(), scratch.data.get(), scratch.state.get(), scratch.path.get(), N);
 
 		const Vector2 goalPos(_navMesh->GetNodeByPos(endID).getCenter());
 
@@ -176,7 +244,7 @@ namespace FusionCrowd
 		NavMeshNode* prevNode = &_navMesh->GetNodeByPos(prev);
 		++itr;
 
-		PortalRoute* route = new PortalRoute(startID, endID, _navMesh->GetVersion());
+		PortalRoutePtr route = std::make_shared<PortalRoute>(startID, endID, _navMesh->GetVersion());
 		route->_bestSmallest = minWidth;
 		for (; itr != path.end(); ++itr)
 		{
@@ -188,58 +256,102 @@ namespace FusionCrowd
 #ifdef _WIN32
 #pragma warning( default : 4267 )
 #endif
-		cacheRoute(startID, endID, route);
-		return route;
+		return cacheRoute(startID, endID, route, minWidth);
 	}
 
-	void PathPlanner::initHeapMemory(size_t nodeCount)
+	float PathPlanner::computeH(unsigned int node, const Vector2& goal)
 	{
-		int threadCount = 1;
-#ifdef _OPENMP
-	logger << Logger::INFO_MSG << "OMP ENABLED!\n";
-	threadCount = omp_get_max_threads();
-#endif
-		if (_DATA)
+		assert(node >= 0 && node < _navMesh->getNodeCount() &&
+			"Trying to compute h for invalid node id");
+		return (_navMesh->GetNodeByPos(node)._center - goal).Length();
+	}
+
+	void PathPlanner::addRoute(RouteShard & shard, PRouteList & routes, PRouteListItr pos, PortalRoutePtr route)
+	{
+		const size_t bytes = RouteBytes(*route);
+		routes.emplace(pos, route, bytes, ++_useClock);
+		shard.bytes += bytes;
+		shard.count++;
+		_bytes += bytes;
+		_count++;
+	}
+
+	PRouteListItr PathPlanner::removeRoute(RouteShard & shard, PRouteList & routes, PRouteListItr pos)
+	{
+		shard.bytes -= pos->bytes;
+		shard.count--;
+		_bytes -= pos->bytes;
+		_count--;
+		_evictions++;
+		// paths still holding the route keep it alive
+		return routes.erase(pos);
+	}
+
+	void PathPlanner::evict(RouteShard & shard, size_t budget)
+	{
+		if (shard.bytes <= budget)
+			return;
+
+		// Routes through changed parts of the navmesh are of no use anymore
+		std::vector<std::pair<size_t, PRouteListItr>> candidates;
+		std::vector<PRouteMapItr> owners;
+		for (PRouteMapItr mapItr = shard.routes.begin(); mapItr != shard.routes.end(); ++mapItr)
 		{
-			delete[] _DATA;
-			_DATA = 0x0;
-			delete[] _STATE;
-			_STATE = 0x0;
-			delete[] _HEAP;
-			_HEAP = 0x0;
-			delete[] _PATH;
-			_PATH = 0x0;
+			PRouteList & routes = mapItr->second;
+			for (PRouteListItr rItr = routes.begin(); rItr != routes.end(); ++rItr)
+			{
+				const size_t age = rItr->route->IsValid(*_navMesh) ? rItr->lastUse.load(std::memory_order_relaxed) : 0;
+				candidates.emplace_back(age, rItr);
+				owners.push_back(mapItr);
+			}
 		}
 
-		DATA_SIZE = 3 * nodeCount; // the number of floats per thread in _data
-		STATE_SIZE = 2 * nodeCount; // the number of bools, per thread, in _state;
-		if (nodeCount)
+		std::vector<size_t> order(candidates.size());
+		for (size_t i = 0; i < order.size(); i++)
+			order[i] = i;
+		std::sort(order.begin(), order.end(), [&candidates](size_t a, size_t b)
+		{
+			return candidates[a].first < candidates[b].first;
+		});
+
+		// Leave some room so that the next few misses do not evict again
+		const size_t target = budget - budget / 4;
+		for (size_t i : order)
 		{
-			_DATA = new float[threadCount * DATA_SIZE];
-			_STATE = new bool[threadCount * STATE_SIZE];
-			_HEAP = new unsigned int[threadCount * nodeCount];
-			_PATH = new unsigned int[threadCount * nodeCount];
+			if (shard.bytes <= target)
+				break;
+
+			removeRoute(shard, owners[i]->second, candidates[i].second);
 		}
-	}
 
-	float PathPlanner::computeH(unsigned int node, const Vector2& goal)
-	{
-		assert(node >= 0 && node < _navMesh->getNodeCount() &&
-			"Trying to compute h for invalid node id");
-		return (_navMesh->GetNodeByPos(node)._center - goal).Length();
+		for (PRouteMapItr mapItr = shard.routes.begin(); mapItr != shard.routes.end();)
+		{
+			if (mapItr->second.empty())
+				mapItr = shard.routes.erase(mapItr);
+			else
+				++mapItr;
+		}
 	}
 
-	PortalRoute* PathPlanner::cacheRoute(unsigned int startID, unsigned int endID,
-	                                     PortalRoute* route)
+	PortalRoutePtr PathPlanner::cacheRoute(unsigned int startID, unsigned int endID,
+	                                       PortalRoutePtr route, float minWidth)
 	{
-		PortalRoute* result = route;
+		PortalRoutePtr result = route;
 		RouteKey key = makeRouteKey(startID, endID);
-		PRouteMapItr mapItr = _routes.find(key);
-		if (mapItr == _routes.end())
+		RouteShard & shard = getShard(key);
+
+		std::unique_lock<std::shared_timed_mutex> lock(shard.lock);
+		PRouteMapItr mapItr = shard.routes.find(key);
+		if (mapItr == shard.routes.end())
 		{
 			// there have been no routes connecting these two points -- it is optimal
-			_routes[key] = PRouteList();
-			_routes[key].push_back(route);
+			PRouteList & routeList = shard.routes[key];
+			addRoute(shard, routeList, routeList.end(), route);
+		}
+		else if (CachedRoute* cached = findRoute(mapItr->second, minWidth))
+		{
+			// another thread has planned the same route meanwhile
+			return cached->route;
 		}
 		else
 		{
@@ -247,32 +359,44 @@ namespace FusionCrowd
 			float w = route->_maxWidth;
 			PRouteList& routeList = mapItr->second;
 			PRouteListItr rItr = routeList.begin();
-			for (; rItr != routeList.end(); ++rItr)
+			while (rItr != routeList.end())
 			{
-				float rWidth = (*rItr)->_maxWidth;
+				// A route through a changed part of the navmesh must not be handed out again
+				if (!rItr->route->IsValid(*_navMesh))
+				{
+					rItr = removeRoute(shard, routeList, rItr);
+					continue;
+				}
+
+				float rWidth = rItr->route->_maxWidth;
 				if (rWidth > w)
 				{
 					// The next width has the capacity to handle agents on this route
 					// It is assumed that it hasn't ever been shown optimal for this route's
 					//	required clearance (otherwise, we would've simply used it.
 					//	Test to see if it is the same route
-					if (route->isEquivalent((*rItr)))
+					if (route->isEquivalent(rItr->route.get()))
 					{
-						result = *rItr;
+						result = rItr->route;
 						assert(route->_bestSmallest < result->_bestSmallest &&
 							"Recomputed an equivalent path which was already shown to be "
 							"sufficiently wide and optimal");
 						result->_bestSmallest = route->_bestSmallest;
+						rItr->lastUse.store(++_useClock, std::memory_order_relaxed);
 					}
 					else
 					{
-						routeList.insert(rItr, route);
+						addRoute(shard, routeList, rItr, route);
 					}
-					return route;
+					break;
 				}
+				++rItr;
 			}
-			routeList.push_back(route);
+			if (rItr == routeList.end())
+				addRoute(shard, routeList, routeList.end(), route);
 		}
-		return route;
+
+		evict(shard, _budget / ROUTE_SHARDS);
+		return result;
 	}
 }
@@ -1,10 +1,15 @@
 #pragma once
 
 #include "Navigation/NavMesh/NavMesh.h"
+#include "Export/Export.h"
 #include "Math/Util.h"
 
+#include <array>
+#include <atomic>
 #include <list>
 #include <map>
+#include <memory>
+#include <shared_mutex>
 #include <unordered_map>
 
 namespace FusionCrowd
@@ -14,31 +19,72 @@ namespace FusionCrowd
 	class PathPlanner;
 
 	typedef size_t RouteKey;
-	typedef std::list<PortalRoute *> PRouteList;
+	typedef std::shared_ptr<PortalRoute> PortalRoutePtr;
+
+	struct CachedRoute
+	{
+		CachedRoute(PortalRoutePtr route, size_t bytes, size_t lastUse) : route(route), bytes(bytes), lastUse(lastUse)
+		{
+		}
+
+		PortalRoutePtr route;
+		size_t bytes;
+		// Tick of the planner use clock, written under the shared lock on hits
+		std::atomic<size_t> lastUse;
+	};
+
+	typedef std::list<CachedRoute> PRouteList;
 	typedef PRouteList::iterator PRouteListItr;
 	typedef PRouteList::const_iterator PRouteListCItr;
 	typedef std::unordered_map<RouteKey, PRouteList> PRouteMap;
 	typedef PRouteMap::iterator PRouteMapItr;
 	typedef PRouteMap::const_iterator PRouteMapCItr;
 
+	// getRoute may be called from several threads at once. A* scratch memory is kept
+	// per thread, the route cache is split into shards with a reader-writer lock each.
+	// Each shard holds at most its part of the byte budget. Going over it evicts routes
+	// made invalid by navmesh changes first, then least recently used ones. Routes are
+	// shared, so evicted routes stay alive while paths of agents refer to them.
 	class PathPlanner
 	{
 	public:
-		PathPlanner(std::shared_ptr<NavMesh> ptr);
+		static const size_t DEFAULT_CACHE_BUDGET = 64 * 1024 * 1024;
+
+		PathPlanner(std::shared_ptr<NavMesh> ptr, size_t cacheBudget = DEFAULT_CACHE_BUDGET);
 		~PathPlanner();
-		PortalRoute* getRoute(unsigned int startID, unsigned int endID, float minWidth);
+		PortalRoutePtr getRoute(unsigned int startID, unsigned int endID, float minWidth);
+
+		void SetCacheBudget(size_t bytes);
+		RouteCacheStats GetCacheStats() const;
 	protected:
-		PortalRoute* computeRoute(unsigned int startID, unsigned int endID, float minWidth);
+		struct RouteShard
+		{
+			std::shared_timed_mutex lock;
+			PRouteMap routes;
+			size_t bytes = 0;
+			size_t count = 0;
+		};
+
+		static const size_t ROUTE_SHARDS = 16;
+
+		RouteShard & getShard(RouteKey key);
+		CachedRoute* findRoute(PRouteList & routes, float minWidth) const;
+		PortalRoutePtr computeRoute(unsigned int startID, unsigned int endID, float minWidth);
 		float computeH(unsigned int node, const DirectX::SimpleMath::Vector2& goal);
-		PortalRoute* cacheRoute(unsigned int startID, unsigned int endID, PortalRoute* route);
-		PRouteMap _routes;
+		PortalRoutePtr cacheRoute(unsigned int startID, unsigned int endID, PortalRoutePtr route, float minWidth);
+		void addRoute(RouteShard & shard, PRouteList & routes, PRouteListItr pos, PortalRoutePtr route);
+		PRouteListItr removeRoute(RouteShard & shard, PRouteList & routes, PRouteListItr pos);
+		// Requires the exclusive lock of the shard
+		void evict(RouteShard & shard, size_t budget);
+		std::array<RouteShard, ROUTE_SHARDS> _shards;
 		std::shared_ptr<NavMesh> _navMesh;
-		void initHeapMemory(size_t nodeCount);
-		size_t DATA_SIZE;
-		size_t STATE_SIZE;
-		unsigned int* _HEAP;
-		unsigned int* _PATH;
-		float* _DATA;
-		bool* _STATE;
+
+		std::atomic<size_t> _budget;
+		std::atomic<size_t> _useClock;
+		std::atomic<size_t> _hits;
+		std::atomic<size_t> _misses;
+		std::atomic<size_t> _evictions;
+		std::atomic<size_t> _bytes;
+		std::atomic<size_t> _count;
 	};
 }
@@ -15,8 +15,8 @@ namespace FusionCrowd
 
 	using namespace DirectX::SimpleMath;
 
-	std::mt19937 _rnd_seed;
 	void PathRandomization::RandomizePath(FusionCrowd::PortalPath* path) {
+		std::mt19937 rnd(path->getSeed());
 		int portal_count = path->getPortalCount();
 		for (int i = 0; i < portal_count; i++) {
 			auto portal = path->getPortal(i);
@@ -27,7 +27,7 @@ namespace FusionCrowd
 			float dr = Vector2::Distance(portal->getRight(), old_wp);
 			Vector2 delta = dl > dr ? portal->getLeft() - old_wp : portal->getRight() - old_wp;
 			std::uniform_real_distribution<float> dist(0.0f, 0.6f);
-			delta *= dist(_rnd_seed);
+			delta *= dist(rnd);
 			path->setWaypoints(i, i + 1, old_wp + delta, path->_headings[i]);
 		}
 	}
@@ -11,8 +11,8 @@ using namespace DirectX::SimpleMath;
 
 namespace FusionCrowd
 {
-	PortalPath::PortalPath(const Vector2& startPos, const Goal & goal, const PortalRoute* route, float agentRadius) :
-		_route(route), _goal(goal), _currPortal(0)
+	PortalPath::PortalPath(const Vector2& startPos, const Goal & goal, std::shared_ptr<const PortalRoute> route, float agentRadius, unsigned int seed) :
+		_route(route), _goal(goal), _currPortal(0), _seed(seed)
 	{
 		computeCrossing(startPos, agentRadius);
 	}
@@ -21,9 +21,9 @@ namespace FusionCrowd
 	{
 	}
 
-	bool PortalPath::IsValid(size_t navMeshVersion) const
+	bool PortalPath::IsValid(const NavMesh & navMesh) const
 	{
-		return _route->IsValid(navMeshVersion);
+		return _route->IsValid(navMesh);
 	}
 
 	void PortalPath::setPrefVelocity(AgentSpatialInfo & agent, float headingCos, float timeStep)
@@ -34,7 +34,7 @@ namespace FusionCrowd
 		if (_currPortal >= PORTAL_COUNT)
 		{
 			// assume that the path is clear
-			_goal.setDirections(agent.GetPos(), agent.radius, agent.prefVelocity);
+			_goal.setDirections(agent.GetPos(), agent.radius, agent.GetPrefVelocity());
 
 
 			if (_goal.getGeometry()->containsPoint(agent.GetPos()))
@@ -55,7 +55,7 @@ namespace FusionCrowd
 					speed = sqrtf(distSq) / timeStep;
 				}
 			}
-			agent.prefVelocity.setSpeed(speed);
+			agent.GetPrefVelocity().setSpeed(speed);
 		}
 		else
 		{
@@ -103,9 +103,9 @@ namespace FusionCrowd
 				}
 			}
 
-			agent.prefVelocity.setSpeed(speed);
-			agent.prefVelocity.setTarget(_waypoints[_currPortal]);
-			portal->setPreferredDirection(agent.GetPos(), agent.radius, goalDir, agent.prefVelocity);
+			agent.GetPrefVelocity().setSpeed(speed);
+			agent.GetPrefVelocity().setTarget(_waypoints[_currPortal]);
+			portal->setPreferredDirection(agent.GetPos(), agent.radius, goalDir, agent.GetPrefVelocity());
 		}
 	}
 
@@ -301,7 +301,7 @@ namespace FusionCrowd
 	{
 		//TODO remove _route->getEndNode() check
 		auto end_node = _route->getEndNode() != NavMeshLocation::NO_NODE ? _route->getEndNode() : startNode;
-		PortalRoute* route = planner->getRoute(startNode, end_node, agentRadius * 2.f);
+		auto route = planner->getRoute(startNode, end_node, agentRadius * 2.f);
 		_waypoints.clear();
 		_headings.clear();
 		_currPortal = 0;
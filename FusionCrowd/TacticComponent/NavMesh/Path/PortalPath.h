@@ -18,7 +18,8 @@ namespace FusionCrowd
 	class PortalPath
 	{
 	public:
-		PortalPath(const DirectX::SimpleMath::Vector2 & startPos, const Goal & goal, const PortalRoute* route, float agentRadius);
+		// seed drives waypoint randomisation, so the path does not depend on paths built before it
+		PortalPath(const DirectX::SimpleMath::Vector2 & startPos, const Goal & goal, std::shared_ptr<const PortalRoute> route, float agentRadius, unsigned int seed = 0);
 		~PortalPath();
 		void setPrefVelocity(AgentSpatialInfo & agent, float headingCos, float timeStep);
 		unsigned int updateLocation(const AgentSpatialInfo & agent, const std::shared_ptr<NavMesh> navMesh,
@@ -32,17 +33,19 @@ namespace FusionCrowd
 		unsigned int getNode(size_t i) const;
 		inline size_t getCurrentPortal() const { return _currPortal; }
 		inline size_t getPortalCount() const { return _route->getPortalCount(); }
+		inline unsigned int getSeed() const { return _seed; }
 		inline const WayPortal* getPortal(size_t i) const { return _route->getPortal(i); }
 		void setWaypoints(size_t start, size_t end, const DirectX::SimpleMath::Vector2& p0,
 		                  const DirectX::SimpleMath::Vector2& dir);
 
-		bool IsValid(size_t navMeshVersion) const;
+		bool IsValid(const NavMesh & navMesh) const;
 
 		std::vector<DirectX::SimpleMath::Vector2> _headings;
 	protected:
-		const PortalRoute* _route;
+		std::shared_ptr<const PortalRoute> _route;
 		const Goal _goal;
 		size_t _currPortal;
+		const unsigned int _seed;
 
 		void computeCrossing(const DirectX::SimpleMath::Vector2& startPos, float agentRadius);
 		std::vector<DirectX::SimpleMath::Vector2> _waypoints;
@@ -1,15 +1,31 @@
 #include "Route.h"
 
+#include "Navigation/NavMesh/NavMesh.h"
+
 namespace FusionCrowd
 {
 	PortalRoute::PortalRoute(unsigned int start, unsigned int end, size_t navMeshVersion) :
-		_startNode(start), _endNode(end), _maxWidth(1e6f), _bestSmallest(1e6f), _length(0.f), _nmVersion(navMeshVersion)
+		_startNode(start), _endNode(end), _maxWidth(1e6f), _bestSmallest(1e6f), _length(0.f), _nmVersion(navMeshVersion), _validVersion(navMeshVersion)
 	{
 	}
 
-	bool PortalRoute::IsValid(size_t navMeshVersion) const
+	bool PortalRoute::IsValid(const NavMesh & navMesh) const
 	{
-		return navMeshVersion == _nmVersion;
+		const size_t version = navMesh.GetVersion();
+		if (version == _validVersion.load(std::memory_order_relaxed))
+			return true;
+
+		if (navMesh.GetNodeVersion(_startNode) > _nmVersion || navMesh.GetNodeVersion(_endNode) > _nmVersion)
+			return false;
+
+		for (const WayPortal & portal : _portals)
+		{
+			if (navMesh.GetNodeVersion(portal._nodeID) > _nmVersion)
+				return false;
+		}
+
+		_validVersion.store(version, std::memory_order_relaxed);
+		return true;
 	}
 
 	void PortalRoute::appendWayPortal(const NavMeshEdge* edge, unsigned int node)
@@ -29,7 +45,7 @@ namespace FusionCrowd
 			{
 				if (_portals[i]._nodeID != route->_portals[i]._nodeID)
 				{
-					break;
+					return false;
 				}
 			}
 			return true;
@@ -2,12 +2,14 @@
 
 #include "WayPortal.h"
 
+#include <atomic>
 #include <vector>
 
 namespace FusionCrowd
 {
 	// FORWARD DECLARATIONS
 	class PathPlanner;
+	class NavMesh;
 	class NavMeshEdge;
 
 	class PortalRoute
@@ -24,7 +26,8 @@ namespace FusionCrowd
 		void appendWayPortal(const NavMeshEdge* edge, unsigned int node);
 		bool isEquivalent(const PortalRoute* route);
 
-		bool IsValid(size_t navMeshVersion) const;
+		// False if any node on the route has been deleted or changed since it was planned
+		bool IsValid(const NavMesh & navMesh) const;
 
 		friend class PathPlanner;
 
@@ -36,5 +39,7 @@ namespace FusionCrowd
 		float _length;
 		std::vector<WayPortal> _portals;
 		size_t _nmVersion;
+		// Latest navmesh version the route was checked against and found valid
+		mutable std::atomic<size_t> _validVersion;
 	};
 }
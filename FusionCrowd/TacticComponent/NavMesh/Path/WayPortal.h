@@ -17,22 +17,22 @@ namespace FusionCrowd
 
 		inline DirectX::SimpleMath::Vector2 getLeft() const
 		{
-			return _p0IsLeft ? _edge->getP0() : _edge->getP1();
+			return _p0IsLeft ? _edge.getP0() : _edge.getP1();
 		}
 
 		inline DirectX::SimpleMath::Vector2 getLeft(float offset) const
 		{
-			return _p0IsLeft ? _edge->getP0(offset) : _edge->getP1(offset);
+			return _p0IsLeft ? _edge.getP0(offset) : _edge.getP1(offset);
 		}
 
 		inline DirectX::SimpleMath::Vector2 getRight() const
 		{
-			return _p0IsLeft ? _edge->getP1() : _edge->getP0();
+			return _p0IsLeft ? _edge.getP1() : _edge.getP0();
 		}
 
 		inline DirectX::SimpleMath::Vector2 getRight(float offset) const
 		{
-			return _p0IsLeft ? _edge->getP1(offset) : _edge->getP0(offset);
+			return _p0IsLeft ? _edge.getP1(offset) : _edge.getP0(offset);
 		}
 
 		DirectX::SimpleMath::Vector2 intersectionPoint(const DirectX::SimpleMath::Vector2& point,
@@ -47,7 +47,8 @@ namespace FusionCrowd
 		~WayPortal();
 
 	protected:
-		const NavMeshEdge* _edge;
+		// Copy of the portal geometry, the navmesh reallocates its edges on modification
+		NavMeshEdge _edge;
 		unsigned int _nodeID;
 		bool _p0IsLeft;
 	};
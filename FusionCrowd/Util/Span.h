@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+namespace FusionCrowd
+{
+	// Read-only view over a contiguous range owned by someone else.
+	// Does not extend lifetime of the data: views returned by NavSystem
+	// stay valid until the next NavSystem::Update, AddAgent or RemoveAgent.
+	template <typename T>
+	class Span
+	{
+	public:
+		Span() : _data(nullptr), _size(0)
+		{ }
+
+		Span(const T * data, size_t size) : _data(data), _size(size)
+		{ }
+
+		Span(const std::vector<T> & v) : _data(v.data()), _size(v.size())
+		{ }
+
+		inline const T * begin() const { return _data; }
+		inline const T * end()   const { return _data + _size; }
+		inline const T * data()  const { return _data; }
+
+		inline size_t size() const { return _size; }
+		inline bool empty()  const { return _size == 0; }
+
+		inline const T & operator[](size_t i) const
+		{
+			assert(i < _size);
+			return _data[i];
+		}
+
+		inline const T & front() const { return (*this)[0]; }
+		inline const T & back()  const { return (*this)[_size - 1]; }
+
+	private:
+		const T * _data;
+		size_t _size;
+	};
+
+	// Writable view, used for caller-provided output buffers
+	template <typename T>
+	class MutableSpan
+	{
+	public:
+		MutableSpan() : _data(nullptr), _size(0)
+		{ }
+
+		MutableSpan(T * data, size_t size) : _data(data), _size(size)
+		{ }
+
+		MutableSpan(std::vector<T> & v) : _data(v.data()), _size(v.size())
+		{ }
+
+		inline T * begin() const { return _data; }
+		inline T * end()   const { return _data + _size; }
+		inline T * data()  const { return _data; }
+
+		inline size_t size() const { return _size; }
+		inline bool empty()  const { return _size == 0; }
+
+		inline T & operator[](size_t i) const
+		{
+			assert(i < _size);
+			return _data[i];
+		}
+
+	private:
+		T * _data;
+		size_t _size;
+	};
+}
@@ -0,0 +1,179 @@
+#include "TaskScheduler.h"
+
+#include <algorithm>
+
+namespace FusionCrowd
+{
+	namespace
+	{
+		thread_local const TaskScheduler * t_workerOf = nullptr;
+	}
+
+	TaskScheduler::TaskScheduler(size_t threadCount) : _queued(0)
+	{
+		SetThreadCount(threadCount);
+	}
+
+	TaskScheduler::~TaskScheduler()
+	{
+		Stop();
+	}
+
+	void TaskScheduler::SetThreadCount(size_t threadCount)
+	{
+		if(threadCount == 0)
+			threadCount = std::thread::hardware_concurrency();
+
+		Stop();
+		_threadCount = std::max<size_t>(threadCount, 1);
+		Start();
+	}
+
+	bool TaskScheduler::IsWorkerThread() const
+	{
+		return t_workerOf == this;
+	}
+
+	void TaskScheduler::Start()
+	{
+		_stop = false;
+		_queued = 0;
+
+		_queues.clear();
+		for(size_t i = 0; i < _threadCount; i++)
+		{
+			_queues.push_back(std::make_unique<Queue>());
+		}
+
+		for(size_t i = 1; i < _threadCount; i++)
+		{
+			_workers.emplace_back(&TaskScheduler::WorkerLoop, this, i);
+		}
+	}
+
+	void TaskScheduler::Stop()
+	{
+		{
+			std::lock_guard<std::mutex> lock(_wakeMutex);
+			_stop = true;
+		}
+		_wake.notify_all();
+
+		for(auto & worker : _workers)
+		{
+			worker.join();
+		}
+		_workers.clear();
+	}
+
+	void TaskScheduler::Run(size_t count, size_t grainSize, const RangeFunc & func)
+	{
+		const size_t maxChunks = (count + grainSize - 1) / grainSize;
+		const size_t chunkSize = (count + std::min(maxChunks, _threadCount * CHUNKS_PER_THREAD) - 1)
+			/ std::min(maxChunks, _threadCount * CHUNKS_PER_THREAD);
+		const size_t chunks = (count + chunkSize - 1) / chunkSize;
+
+		Job job;
+		job.func = &func;
+		job.pending = chunks;
+
+		{
+			std::lock_guard<std::mutex> lock(_wakeMutex);
+			_queued += chunks;
+		}
+
+		for(size_t chunk = 0; chunk < chunks; chunk++)
+		{
+			Queue & queue = *_queues[chunk % _threadCount];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			queue.tasks.push_back({ &job, chunk * chunkSize, std::min(count, (chunk + 1) * chunkSize) });
+		}
+		_wake.notify_all();
+
+		// Help with any queued work, not only our own. Once nothing is left to take,
+		// the rest of our tasks are running on workers.
+		Task task;
+		while(TryPop(0, task))
+		{
+			Execute(task);
+		}
+
+		{
+			std::unique_lock<std::mutex> lock(job.doneMutex);
+			job.done.wait(lock, [&job] { return job.pending == 0; });
+		}
+
+		if(job.error)
+			std::rethrow_exception(job.error);
+	}
+
+	bool TaskScheduler::TryPop(size_t queue, Task & task)
+	{
+		{
+			Queue & own = *_queues[queue];
+			std::lock_guard<std::mutex> lock(own.mutex);
+			if(!own.tasks.empty())
+			{
+				task = own.tasks.back();
+				own.tasks.pop_back();
+				_queued--;
+				return true;
+			}
+		}
+
+		for(size_t i = 1; i < _queues.size(); i++)
+		{
+			Queue & victim = *_queues[(queue + i) % _queues.size()];
+			std::lock_guard<std::mutex> lock(victim.mutex);
+			if(!victim.tasks.empty())
+			{
+				task = victim.tasks.front();
+				victim.tasks.pop_front();
+				_queued--;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	void TaskScheduler::Execute(const Task & task)
+	{
+		Job & job = *task.job;
+		try
+		{
+			(*job.func)(task.begin, task.end);
+		}
+		catch(...)
+		{
+			std::lock_guard<std::mutex> lock(job.errorMutex);
+			if(!job.error)
+				job.error = std::current_exception();
+		}
+
+		// Job lives on the caller's stack and may be gone as soon as the lock is released
+		std::lock_guard<std::mutex> lock(job.doneMutex);
+		if(--job.pending == 0)
+			job.done.notify_one();
+	}
+
+	void TaskScheduler::WorkerLoop(size_t queue)
+	{
+		t_workerOf = this;
+
+		while(true)
+		{
+			Task task;
+			if(TryPop(queue, task))
+			{
+				Execute(task);
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(_wakeMutex);
+			_wake.wait(lock, [this] { return _stop || _queued > 0; });
+			if(_stop)
+				return;
+		}
+	}
+}
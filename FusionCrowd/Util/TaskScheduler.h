@@ -0,0 +1,108 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace FusionCrowd
+{
+	// Work-stealing scheduler shared by the simulator, navigation system and components.
+	// Every worker owns a deque: it takes tasks from the back of its own deque and
+	// steals from the front of the others. Deque 0 belongs to external callers,
+	// which help with the work while they wait for their loop to finish.
+	class TaskScheduler
+	{
+	public:
+		// Thread count includes the calling thread, 0 means hardware concurrency
+		explicit TaskScheduler(size_t threadCount = 1);
+		~TaskScheduler();
+
+		TaskScheduler(const TaskScheduler &) = delete;
+		TaskScheduler & operator=(const TaskScheduler &) = delete;
+
+		// Must not be called while a loop is running
+		void SetThreadCount(size_t threadCount);
+		size_t GetThreadCount() const { return _threadCount; }
+
+		// Calls func(begin, end) for disjoint ranges covering [0, count) and returns when
+		// all of them are done. Ranges are at least grainSize long, except the last one.
+		// Runs inline with one thread and when called from a worker.
+		// The first exception thrown by func is rethrown to the caller.
+		template <typename Func>
+		void ParallelFor(size_t count, Func && func, size_t grainSize = 1);
+
+	private:
+		using RangeFunc = std::function<void(size_t, size_t)>;
+
+		struct Job
+		{
+			const RangeFunc * func;
+			std::mutex errorMutex;
+			std::exception_ptr error;
+
+			// Guards pending, the caller sleeps on done once nothing is left to steal
+			std::mutex doneMutex;
+			std::condition_variable done;
+			size_t pending;
+		};
+
+		struct Task
+		{
+			Job * job;
+			size_t begin;
+			size_t end;
+		};
+
+		struct Queue
+		{
+			std::mutex mutex;
+			std::deque<Task> tasks;
+		};
+
+		// Tasks per thread, more chunks balance uneven per agent costs
+		static const size_t CHUNKS_PER_THREAD = 4;
+
+		void Run(size_t count, size_t grainSize, const RangeFunc & func);
+		bool TryPop(size_t queue, Task & task);
+		void Execute(const Task & task);
+		void WorkerLoop(size_t queue);
+		bool IsWorkerThread() const;
+
+		void Start();
+		void Stop();
+
+		size_t _threadCount = 1;
+
+		std::vector<std::unique_ptr<Queue>> _queues;
+		std::vector<std::thread> _workers;
+
+		std::mutex _wakeMutex;
+		std::condition_variable _wake;
+		// Tasks in all queues, raised before tasks are published so it never underflows
+		std::atomic<size_t> _queued;
+		bool _stop = false;
+	};
+
+	template <typename Func>
+	void TaskScheduler::ParallelFor(size_t count, Func && func, size_t grainSize)
+	{
+		if(count == 0)
+			return;
+
+		grainSize = grainSize > 0 ? grainSize : 1;
+		if(_threadCount <= 1 || count <= grainSize || IsWorkerThread())
+		{
+			func((size_t) 0, count);
+			return;
+		}
+
+		const RangeFunc rangeFunc = [&func](size_t begin, size_t end) { func(begin, end); };
+		Run(count, grainSize, rangeFunc);
+	}
+}
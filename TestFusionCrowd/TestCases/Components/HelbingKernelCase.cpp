@@ -0,0 +1,33 @@
+#include "pch.h"
+#include "HelbingKernelCase.h"
+
+#include "Export/ComponentId.h"
+#include "TestCases/Utils.h"
+
+#include <cmath>
+
+namespace TestFusionCrowd
+{
+	using namespace FusionCrowd;
+
+	HelbingKernelCase::HelbingKernelCase(size_t agentsNum, size_t steps) : ITestCase(agentsNum, steps)
+	{
+	}
+
+	void HelbingKernelCase::Pre()
+	{
+		std::shared_ptr<ISimulatorBuilder> builder(BuildSimulator(), BuilderDeleter);
+		builder->WithNavMesh("Resources/square.nav")
+			->WithOp(ComponentIds::HELBING_ID);
+
+		_sim = std::shared_ptr<ISimulatorFacade>(builder->Build(), SimulatorFacadeDeleter);
+
+		// About 2 agents per square metre
+		const float side = sqrtf(_agentsNum / 2.f);
+		for (size_t i = 0; i < _agentsNum; i++)
+		{
+			size_t id = _sim->AddAgent(RandFloat(0.f, side), RandFloat(0.f, side), ComponentIds::HELBING_ID, ComponentIds::NAVMESH_ID, ComponentIds::NO_COMPONENT);
+			_sim->SetAgentGoal(id, Point { RandFloat(0.f, side), RandFloat(0.f, side) });
+		}
+	}
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "TestCases/ITestCase.h"
+
+#include "Export/Export.h"
+
+#include <string>
+
+namespace TestFusionCrowd
+{
+	// Dense Helbing crowd to time the force kernel, UnitTest checks the vector paths against the scalar one
+	class HelbingKernelCase : public ITestCase
+	{
+	public:
+		HelbingKernelCase(size_t agentsNum = 30000, size_t steps = 100);
+
+		void Pre() override;
+		std::string GetName() const override { return "HelbingKernel"; };
+	};
+}
@@ -3,37 +3,234 @@
 
 #include "Math/consts.h"
 #include "Export/Export.h"
+#include "Navigation/NeighborInfo.h"
+#include "OperationComponent/Zanlungo/ZanlungoInteraction.h"
 #include "TestCases/Utils.h"
 
+#include <chrono>
+#include <iostream>
+#include <vector>
+
 namespace TestFusionCrowd
 {
 	using namespace DirectX::SimpleMath;
 	using namespace FusionCrowd;
 
+	namespace
+	{
+		float RayCircleTTC(Vector2 dir, Vector2 center, float radius)
+		{
+			const float a = dir.LengthSquared();
+			const float b = -2 * dir.Dot(center);
+			const float c = center.LengthSquared() - (radius * radius);
+			const float discr = b * b - 4 * a * c;
+			if (discr < 0.f) return Math::INFTY;
+
+			const float sqrtDiscr = sqrtf(discr);
+			const float t0 = (-b - sqrtDiscr) / (2.f * a);
+			const float t1 = (-b + sqrtDiscr) / (2.f * a);
+			if ((t0 < 0.f && t1 > 0.f) || (t1 < 0.f && t0 > 0.f)) return 0.f;
+			if (t0 < t1 && t0 > 0.f) return t0;
+			if (t1 > 0.f) return t1;
+			return Math::INFTY;
+		}
+
+		// Interaction as ZanlungoComponent did it before AgentInteraction: both passes fetch
+		// the neighbourhood as a fresh vector, GetNeighbours returned it by value
+		bool CopyingInteraction(
+			const Zanlungo::InteractionParams & params,
+			Vector2 pos, Vector2 vel, float radius,
+			Span<NeighborInfo> neighbours, float obstacleTTI, float timeStep,
+			float & outTTI, Vector2 & force)
+		{
+			bool interacts = false;
+			float T_i = Math::INFTY;
+			float t_collision = Math::INFTY;
+
+			std::vector<NeighborInfo> nearAgents(neighbours.begin(), neighbours.end());
+			for (size_t j = 0; j < nearAgents.size(); ++j)
+			{
+				NeighborInfo other = nearAgents[j];
+				const Vector2 relVel = vel - other.vel;
+				const Vector2 relPos = pos - other.pos;
+
+				const float contactT = RayCircleTTC(relVel, -relPos, radius + other.radius);
+				if (contactT < t_collision) {
+					t_collision = contactT;
+					interacts = true;
+				}
+				else if (t_collision == Math::INFTY) {
+					const float dp = -relPos.Dot(relVel);
+					if (dp > 0.f) {
+						const float t_ij = dp / relVel.LengthSquared();
+						if (t_ij < T_i) {
+							T_i = t_ij;
+							interacts = true;
+						}
+					}
+				}
+			}
+
+			if (obstacleTTI < T_i) {
+				T_i = obstacleTTI;
+				interacts = true;
+			}
+			if (t_collision < Math::INFTY) T_i = t_collision;
+			if (T_i < timeStep) T_i = timeStep;
+
+			outTTI = T_i;
+			if (!interacts)
+				return false;
+
+			std::vector<NeighborInfo> forceAgents(neighbours.begin(), neighbours.end());
+			for (size_t j = 0; j < forceAgents.size(); ++j)
+			{
+				NeighborInfo other = forceAgents[j];
+
+				Vector2 D_ij = (pos + vel * T_i) - (other.pos + other.vel * T_i);
+				if (D_ij.Dot(vel - other.vel) > 0.f) continue;
+
+				float dist = D_ij.Length();
+				D_ij /= dist;
+				dist -= (radius + other.radius);
+
+				float magnitude = params.agentScale * (vel - other.vel).Length() / T_i;
+				if (magnitude >= 1e15f) {
+					magnitude = 1e15f;
+				}
+				force += D_ij * (magnitude * expf(-dist / params.forceDistance));
+			}
+
+			return true;
+		}
+	}
+
 	ZanlungoCase::ZanlungoCase() : ITestCase(100, 1000)
 	{
 	}
 
 	void ZanlungoCase::Pre()
 	{
-		std::string navPath = "Resources/square.nav";
+		_sim = BuildScene();
+
+		BenchInteraction();
+	}
 
+	std::shared_ptr<ISimulatorFacade> ZanlungoCase::BuildScene() const
+	{
 		std::shared_ptr<ISimulatorBuilder> builder(BuildSimulator(), BuilderDeleter);
 		builder->WithNavMesh("Resources/square.nav")
 			->WithOp(FusionCrowd::ComponentIds::ZANLUNGO_ID);
 
-		_sim = std::shared_ptr<FusionCrowd::ISimulatorFacade>(builder->Build(), SimulatorFacadeDeleter);
+		std::shared_ptr<ISimulatorFacade> sim(builder->Build(), SimulatorFacadeDeleter);
 
 		for (int i = 0; i < (totalAgents / 2 - 1); i++)
 		{
-			size_t id = _sim->AddAgent(RandFloat(2.0f, 4.0f), RandFloat(10.0f, 20.0f), ComponentIds::ZANLUNGO_ID, ComponentIds::NAVMESH_ID, -1);
-			_sim->SetAgentGoal(id, Point { RandFloat(14.0f, 16.0f), RandFloat(10.0f, 20.0f) });
+			size_t id = sim->AddAgent(RandFloat(2.0f, 4.0f), RandFloat(10.0f, 20.0f), ComponentIds::ZANLUNGO_ID, ComponentIds::NAVMESH_ID, -1);
+			sim->SetAgentGoal(id, Point { RandFloat(14.0f, 16.0f), RandFloat(10.0f, 20.0f) });
 		}
 
 		for (int i = (totalAgents / 2 - 1); i < totalAgents; i++)
 		{
-			size_t id = _sim->AddAgent(RandFloat(8.0f, 10.0f), RandFloat(20.0f, 25.0f), ComponentIds::ZANLUNGO_ID, ComponentIds::NAVMESH_ID, -1);
-			_sim->SetAgentGoal(id, Point { RandFloat(8.0f, 10.0f), RandFloat(0.0f, 5.0f) });
+			size_t id = sim->AddAgent(RandFloat(8.0f, 10.0f), RandFloat(20.0f, 25.0f), ComponentIds::ZANLUNGO_ID, ComponentIds::NAVMESH_ID, -1);
+			sim->SetAgentGoal(id, Point { RandFloat(8.0f, 10.0f), RandFloat(0.0f, 5.0f) });
 		}
+
+		return sim;
+	}
+
+	std::shared_ptr<ISimulatorFacade> ZanlungoCase::BuildBenchScene() const
+	{
+		std::shared_ptr<ISimulatorBuilder> builder(BuildSimulator(), BuilderDeleter);
+		builder->WithNavMesh("Resources/square.nav")
+			->WithOp(FusionCrowd::ComponentIds::ZANLUNGO_ID);
+
+		std::shared_ptr<ISimulatorFacade> sim(builder->Build(), SimulatorFacadeDeleter);
+
+		// Everyone heads for the mirrored point, so flows cross at the center
+		for (int i = 0; i < benchAgents; i++)
+		{
+			const float x = RandFloat(0.f, benchSide);
+			const float y = RandFloat(0.f, benchSide);
+			size_t id = sim->AddAgent(x, y, ComponentIds::ZANLUNGO_ID, ComponentIds::NAVMESH_ID, -1);
+			sim->SetAgentGoal(id, Point { benchSide - x, benchSide - y });
+		}
+
+		return sim;
+	}
+
+	void ZanlungoCase::BenchInteraction() const
+	{
+		using namespace std::chrono;
+		using namespace FusionCrowd::Zanlungo;
+
+		auto sim = BuildBenchScene();
+		for (size_t i = 0; i < benchWarmupSteps; i++)
+		{
+			sim->DoStep();
+		}
+
+		FCArray<AgentInfo> agents(sim->GetAgentCount());
+		sim->GetAgents(agents);
+
+		const size_t count = agents.size();
+		std::vector<std::vector<NeighborInfo>> neighbourhoods(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			for (size_t j = 0; j < count; j++)
+			{
+				const Vector2 relPos(agents[j].posX - agents[i].posX, agents[j].posY - agents[i].posY);
+				if (i == j || relPos.Length() > searchRadius)
+					continue;
+
+				NeighborInfo n;
+				n.id = agents[j].id;
+				n.pos = Vector2(agents[j].posX, agents[j].posY);
+				n.vel = Vector2(agents[j].velX, agents[j].velY);
+				n.radius = agents[j].radius;
+				neighbourhoods[i].push_back(n);
+			}
+		}
+
+		// ZanlungoComponent defaults
+		const InteractionParams params { 2000.f, 0.08f };
+		const float timeStep = 0.1f;
+
+		auto run = [&](decltype(&AgentInteraction) variant, std::vector<Vector2> & forces)
+		{
+			forces.assign(count, Vector2(0.f, 0.f));
+
+			high_resolution_clock::time_point t1 = high_resolution_clock::now();
+			for (size_t r = 0; r < benchRepeats; r++)
+			{
+				for (size_t i = 0; i < count; i++)
+				{
+					const AgentInfo & a = agents[i];
+					Vector2 force(0.f, 0.f);
+					float T_i;
+					variant(params, Vector2(a.posX, a.posY), Vector2(a.velX, a.velY), a.radius,
+						neighbourhoods[i], Math::INFTY, timeStep, T_i, force);
+					forces[i] = force;
+				}
+			}
+			high_resolution_clock::time_point t2 = high_resolution_clock::now();
+
+			return duration_cast<microseconds>(t2 - t1).count();
+		};
+
+		size_t neighbours = 0;
+		for (const auto & n : neighbourhoods)
+		{
+			neighbours += n.size();
+		}
+
+		std::vector<Vector2> copyingForces, inPlaceForces;
+		const long long copying = run(CopyingInteraction, copyingForces);
+		const long long inPlace = run(AgentInteraction, inPlaceForces);
+
+		std::cout << "  Interaction, " << benchRepeats << " x " << count << " agents, "
+			<< neighbours / count << " neighbours on average:"
+			<< " copying=" << copying << "us"
+			<< " in-place=" << inPlace << "us" << std::endl;
 	}
 }
@@ -12,6 +12,8 @@
 
 namespace TestFusionCrowd
 {
+	// Crossing flows under Zanlungo. Pre also times AgentInteraction against the copying code
+	// it replaced, on neighbourhoods taken from a large crowd some steps in.
 	class ZanlungoCase : public ITestCase
 	{
 	public:
@@ -21,6 +23,10 @@ namespace TestFusionCrowd
 		std::string GetName() const override { return "Zanlungo"; };
 
 	private:
+		std::shared_ptr<FusionCrowd::ISimulatorFacade> BuildScene() const;
+		std::shared_ptr<FusionCrowd::ISimulatorFacade> BuildBenchScene() const;
+		void BenchInteraction() const;
+
 		const float worldSide = 20;
 		const int totalAgents = 10;
 
@@ -30,6 +36,12 @@ namespace TestFusionCrowd
 		const float agentsSpread = 1.f;
 		const float searchRadius = 5;
 
+		// Neighbourhoods of the bench crowd take several megabytes, more than fits in cache
+		const int benchAgents = 2000;
+		const float benchSide = 40;
+		const size_t benchWarmupSteps = 20;
+		const size_t benchRepeats = 50;
+
 		int control1 = 0;
 		int control2 = 0;
 	};
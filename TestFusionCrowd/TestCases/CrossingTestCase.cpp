@@ -8,9 +8,9 @@ using namespace FusionCrowd;
 
 namespace TestFusionCrowd
 {
-	CrossingTestCase::CrossingTestCase(FusionCrowd::ComponentId opComponent, size_t agentsNum, size_t simulationSteps, bool writeTrajectories):
+	CrossingTestCase::CrossingTestCase(FusionCrowd::ComponentId opComponent, size_t agentsNum, size_t simulationSteps, bool writeTrajectories, size_t threadCount):
 		ITestCase(agentsNum, simulationSteps, writeTrajectories),
-		_opComponent(opComponent)
+		_opComponent(opComponent), _threadCount(threadCount)
 	{
 	}
 
@@ -18,7 +18,8 @@ namespace TestFusionCrowd
 	{
 		std::unique_ptr<ISimulatorBuilder, decltype(&BuilderDeleter)> builder(BuildSimulator(), BuilderDeleter);
 		builder->WithNavMesh("Resources/crossing.nav")
-			->WithOp(_opComponent);
+			->WithOp(_opComponent)
+			->WithThreadCount(_threadCount);
 
 		_sim = std::unique_ptr<ISimulatorFacade, decltype(&SimulatorFacadeDeleter)>(builder->Build(), SimulatorFacadeDeleter);
 
@@ -7,6 +7,7 @@
 #include <memory>
 #include <vector>
 #include <chrono>
+#include <string>
 
 namespace TestFusionCrowd
 {
@@ -17,13 +18,16 @@ namespace TestFusionCrowd
 			FusionCrowd::ComponentId opComponent=FusionCrowd::ComponentIds::KARAMOUZAS_ID,
 			size_t agentsNum=10000,
 			size_t simulationSteps=5000,
-			bool writeTrajectories=false
+			bool writeTrajectories=false,
+			size_t threadCount=0
 		);
 
 		void Pre() override;
-		std::string GetName() const override { return "Crossing"; };
+		std::string GetName() const override { return _threadCount == 0 ? "Crossing" : "Crossing_" + std::to_string(_threadCount) + "threads"; };
 
 	private:
 		FusionCrowd::ComponentId _opComponent;
+		// 0 means hardware concurrency
+		size_t _threadCount;
 	};
 }
@@ -6,8 +6,8 @@ using namespace FusionCrowd;
 
 namespace TestFusionCrowd
 {
-	ExchangeCircleCase::ExchangeCircleCase(size_t agentsNum, size_t steps, ComponentId op, bool writeTraj)
-		: ITestCase(agentsNum, steps, writeTraj), _op(op)
+	ExchangeCircleCase::ExchangeCircleCase(size_t agentsNum, size_t steps, ComponentId op, bool writeTraj, size_t threadCount)
+		: ITestCase(agentsNum, steps, writeTraj), _op(op), _threadCount(threadCount)
 	{ }
 
 	void ExchangeCircleCase::Pre()
@@ -15,7 +15,8 @@ namespace TestFusionCrowd
 		std::shared_ptr<ISimulatorBuilder> builder(BuildSimulator(), BuilderDeleter);
 		builder
 			->WithNavMesh("Resources/square.nav")
-			->WithOp(_op);
+			->WithOp(_op)
+			->WithThreadCount(_threadCount);
 
 		_sim = std::shared_ptr<FusionCrowd::ISimulatorFacade>(builder->Build(), SimulatorFacadeDeleter);
 
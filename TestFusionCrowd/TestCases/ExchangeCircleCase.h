@@ -4,16 +4,20 @@
 
 #include "Export/ComponentId.h"
 
+#include <string>
+
 namespace TestFusionCrowd
 {
 	class ExchangeCircleCase : public ITestCase
 	{
 	public:
-		ExchangeCircleCase(size_t agentsNum, size_t steps, FusionCrowd::ComponentId op, bool writeTraj);
+		ExchangeCircleCase(size_t agentsNum, size_t steps, FusionCrowd::ComponentId op, bool writeTraj, size_t threadCount = 0);
 
 		void Pre() override;
-		std::string GetName() const override { return "ExchangeCircleCase"; };
+		std::string GetName() const override { return _threadCount == 0 ? "ExchangeCircleCase" : "ExchangeCircleCase_" + std::to_string(_threadCount) + "threads"; };
 	private:
 		FusionCrowd::ComponentId _op;
+		// 0 means hardware concurrency
+		size_t _threadCount;
 	};
 }
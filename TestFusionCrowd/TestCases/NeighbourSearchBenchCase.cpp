@@ -21,7 +21,7 @@ namespace TestFusionCrowd
 	using namespace std::chrono;
 	using namespace FusionCrowd;
 
-	NeighbourSearchBenchCase::NeighbourSearchBenchCase(float coef) : ITestCase(5 * worldSide * worldSide, 100), _coef(coef)
+	NeighbourSearchBenchCase::NeighbourSearchBenchCase(float coef, NeighbourSearchMode mode) : ITestCase(5 * worldSide * worldSide, 100), _coef(coef), _mode(mode)
 	{
 	}
 
@@ -35,6 +35,7 @@ namespace TestFusionCrowd
 			->WithOp(FusionCrowd::ComponentIds::ORCA_ID);
 
 		_sim = std::shared_ptr<ISimulatorFacade>(builder->Build(), SimulatorFacadeDeleter);
+		_sim->GetNavSystem()->SetNeighbourSearchMode(_mode);
 
 		for (int i = 0; i < _agentsNum; i++)
 		{
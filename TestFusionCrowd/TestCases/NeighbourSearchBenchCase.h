@@ -8,16 +8,20 @@
 
 #include "Math/Util.h"
 #include "Export/IRecording.h"
+#include "Export/INavSystemPublic.h"
 
 namespace TestFusionCrowd
 {
 	class NeighbourSearchBenchCase : public ITestCase
 	{
 	public:
-		NeighbourSearchBenchCase(float coef);
+		NeighbourSearchBenchCase(float coef, FusionCrowd::NeighbourSearchMode mode = FusionCrowd::CountingSort);
 
 		void Pre() override;
-		std::string GetName() const override { return "NeighbourSearch"; };
+		std::string GetName() const override
+		{
+			return _mode == FusionCrowd::CountingSort ? "NeighbourSearch_CountingSort" : "NeighbourSearch_HashedGrid";
+		};
 
 	private:
 		const float worldSide = 100;
@@ -31,5 +35,6 @@ namespace TestFusionCrowd
 		int control1 = 0;
 		int control2 = 0;
 		float _coef;
+		FusionCrowd::NeighbourSearchMode _mode;
 	};
 }
@@ -17,6 +17,7 @@
 #include "TestCases/StenkaNaStenkuTestCase.h"
 
 #include "TestCases/Components/ZanlungoCase.h"
+#include "TestCases/Components/HelbingKernelCase.h"
 #include "TestCases/Components/NavGraphTestCase.h"
 #include "TestCases/Components/FsmTestCase.h"
 #include "TestCases/Components/GoalShapeTestCase.h"
@@ -114,7 +115,10 @@ int main()
 		// std::shared_ptr<ITestCase>((ITestCase*) new FsmTestCase(FusionCrowd::ComponentIds::BICYCLE, 50, 2000, true)),
 		// std::shared_ptr<ITestCase>((ITestCase*) new FsmTestCase(FusionCrowd::ComponentIds::BICYCLE, 50, 2000, true)),
 		// std::shared_ptr<ITestCase>((ITestCase*) new TradeshowTestCase(1025, 1000, true)),
+		// std::shared_ptr<ITestCase>((ITestCase*) new NeighbourSearchBenchCase(1.f, FusionCrowd::HashedGrid)),
+		// std::shared_ptr<ITestCase>((ITestCase*) new NeighbourSearchBenchCase(1.f, FusionCrowd::CountingSort)),
 		// std::shared_ptr<ITestCase>((ITestCase*) new ZanlungoCase()),
+		// std::shared_ptr<ITestCase>((ITestCase*) new HelbingKernelCase(30000, 100)),
 		// std::shared_ptr<ITestCase>((ITestCase*) new CrossingTestCase(FusionCrowd::ComponentIds::KARAMOUZAS_ID, 30, 1000, false)),
 		// std::shared_ptr<ITestCase>((ITestCase*) new PinholeTestCase(FusionCrowd::ComponentIds::KARAMOUZAS_ID, 2, 100)),
 		// std::shared_ptr<ITestCase>((ITestCase*) new TshapedFancyTestCase(FusionCrowd::ComponentIds::ORCA_ID, 4, 1000, true)),
@@ -122,6 +126,15 @@ int main()
 		// std::shared_ptr<ITestCase>((ITestCase*) new StenkaNaStenkuTestCase(500, 1000, true)),
 		// std::shared_ptr<ITestCase>((ITestCase*) new GroupMovementTestCase(1000, true)),
 		// std::shared_ptr<ITestCase>((ITestCase*) new ExchangeCircleCase(7500, 1000, FusionCrowd::ComponentIds::ORCA_ID, false)),
+		// Thread scaling of operation components, compare step time stats between thread counts
+		// std::shared_ptr<ITestCase>((ITestCase*) new CrossingTestCase(FusionCrowd::ComponentIds::KARAMOUZAS_ID, 10000, 500, false, 1)),
+		// std::shared_ptr<ITestCase>((ITestCase*) new CrossingTestCase(FusionCrowd::ComponentIds::KARAMOUZAS_ID, 10000, 500, false, 2)),
+		// std::shared_ptr<ITestCase>((ITestCase*) new CrossingTestCase(FusionCrowd::ComponentIds::KARAMOUZAS_ID, 10000, 500, false, 4)),
+		// std::shared_ptr<ITestCase>((ITestCase*) new CrossingTestCase(FusionCrowd::ComponentIds::KARAMOUZAS_ID, 10000, 500, false, 8)),
+		// std::shared_ptr<ITestCase>((ITestCase*) new ExchangeCircleCase(7500, 500, FusionCrowd::ComponentIds::KARAMOUZAS_ID, false, 1)),
+		// std::shared_ptr<ITestCase>((ITestCase*) new ExchangeCircleCase(7500, 500, FusionCrowd::ComponentIds::KARAMOUZAS_ID, false, 2)),
+		// std::shared_ptr<ITestCase>((ITestCase*) new ExchangeCircleCase(7500, 500, FusionCrowd::ComponentIds::KARAMOUZAS_ID, false, 4)),
+		// std::shared_ptr<ITestCase>((ITestCase*) new ExchangeCircleCase(7500, 500, FusionCrowd::ComponentIds::KARAMOUZAS_ID, false, 8)),
 		// std::shared_ptr<ITestCase>((ITestCase*) new GroupPerformanceTestCase()),
 		//std::shared_ptr<ITestCase>((ITestCase*) new GoalShapeTestCase())
 	};
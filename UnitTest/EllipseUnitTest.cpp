@@ -0,0 +1,113 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include <cmath>
+#include <random>
+
+#include "AgentShape/Ellipse.h"
+#include "OperationComponent/GCFComponent.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+using namespace DirectX::SimpleMath;
+using namespace FusionCrowd;
+using namespace FusionCrowd::AgentShape;
+
+namespace UnitTest
+{
+	TEST_CLASS(EllipseUnitTest)
+	{
+	public:
+		TEST_METHOD(Ellipse__RadiusInPointDirection_on_axes)
+		{
+			const Vector2 center(1.f, 2.f);
+			const float angle = 0.7f;
+			const Ellipse ellipse(center, Vector2(0.5f, 0.2f), angle);
+
+			const Vector2 major(cos(angle), sin(angle));
+			const Vector2 minor(-major.y, major.x);
+
+			Assert::IsTrue(std::abs(ellipse.RadiusInPointDirection(center + 3.f * major) - 0.5f) < EPS, L"Wrong radius along the major axis.");
+			Assert::IsTrue(std::abs(ellipse.RadiusInPointDirection(center - 3.f * major) - 0.5f) < EPS, L"Wrong radius along the major axis.");
+			Assert::IsTrue(std::abs(ellipse.RadiusInPointDirection(center + 2.f * minor) - 0.2f) < EPS, L"Wrong radius along the minor axis.");
+			Assert::IsTrue(std::abs(ellipse.RadiusInPointDirection(center - 2.f * minor) - 0.2f) < EPS, L"Wrong radius along the minor axis.");
+
+			// Boundary point (a cos t, b sin t) lies at distance r along the diagonal where 1/r^2 = (1/a^2 + 1/b^2) / 2
+			const float diagonal = 1.f / sqrtf(0.5f / (0.5f * 0.5f) + 0.5f / (0.2f * 0.2f));
+			Assert::IsTrue(std::abs(ellipse.RadiusInPointDirection(center + major + minor) - diagonal) < EPS, L"Wrong radius between the axes.");
+		}
+
+		TEST_METHOD(Ellipse__RadiusInPointDirection_of_circle)
+		{
+			const Ellipse circle(Vector2(-3.f, 4.f), Vector2(0.3f, 0.3f), 1.2f);
+
+			for (int i = 0; i < 16; i++)
+			{
+				const float t = i * 0.4f;
+				Assert::IsTrue(std::abs(circle.RadiusInPointDirection(Vector2(-3.f + cos(t), 4.f + sin(t))) - 0.3f) < EPS);
+			}
+		}
+
+		TEST_METHOD(Ellipse__Approx_distance_within_axis_bound)
+		{
+			std::mt19937 rnd(7);
+			for (size_t i = 0; i < PAIRS; i++)
+			{
+				Ellipse agent, other;
+				RandomPair(rnd, agent, other);
+
+				const float bound = (agent.GetLargerAxis() - agent.GetSmallerAxis()) + (other.GetLargerAxis() - other.GetSmallerAxis());
+				const float error = std::abs(agent.ApproxDistanceOfClosestApproach(other) - agent.DistanceOfClosestApproach(other));
+
+				Assert::IsTrue(error <= bound + EPS, L"Approximation is off by more than the axis differences.");
+			}
+		}
+
+		TEST_METHOD(Ellipse__Approx_distance_within_GCF_accuracy)
+		{
+			const GCF::DistanceAccuracy accuracy;
+
+			std::mt19937 rnd(11);
+			size_t approximated = 0;
+			for (size_t i = 0; i < PAIRS; i++)
+			{
+				Ellipse agent, other;
+				RandomPair(rnd, agent, other);
+
+				// Same choice GCFComponent makes before taking the approximation
+				const float gap = agent.ellipseCenterDistance(other) - agent.GetLargerAxis() - other.GetLargerAxis();
+				const float maxError = (agent.GetLargerAxis() - agent.GetSmallerAxis()) + (other.GetLargerAxis() - other.GetSmallerAxis());
+				if (maxError > accuracy.absoluteError && maxError > accuracy.relativeError * gap)
+					continue;
+
+				approximated++;
+				const float exact = agent.DistanceOfClosestApproach(other);
+				const float error = std::abs(agent.ApproxDistanceOfClosestApproach(other) - exact);
+				const float effDist = agent.ellipseCenterDistance(other) - exact;
+
+				Assert::IsTrue(error <= accuracy.absoluteError + EPS || error <= accuracy.relativeError * effDist + EPS,
+					L"Approximation is off by more than the configured accuracy.");
+			}
+
+			Assert::IsTrue(approximated > 0, L"No pair was close enough to circles to be approximated.");
+		}
+
+	private:
+		static constexpr float EPS = 1e-4f;
+		static const size_t PAIRS = 10000;
+
+		// Non-overlapping ellipses of GCF agent sizes, from circles to twice as long as wide
+		static void RandomPair(std::mt19937 & rnd, Ellipse & agent, Ellipse & other)
+		{
+			auto uniform = [&rnd](float min, float max) { return std::uniform_real_distribution<float>(min, max)(rnd); };
+
+			const float a1 = uniform(0.18f, 0.4f);
+			const float a2 = uniform(0.18f, 0.4f);
+			agent = Ellipse(Vector2(0.f, 0.f), Vector2(a1, uniform(a1 / 2, a1)), uniform(0.f, 6.28f));
+
+			const float dist = a1 + a2 + uniform(0.f, 3.f);
+			const float dir = uniform(0.f, 6.28f);
+			other = Ellipse(Vector2(dist * cos(dir), dist * sin(dir)), Vector2(a2, uniform(a2 / 2, a2)), uniform(0.f, 6.28f));
+		}
+	};
+}
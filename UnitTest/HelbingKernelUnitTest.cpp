@@ -0,0 +1,119 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "OperationComponent/Helbing/HelbingForceKernel.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+using namespace FusionCrowd;
+using namespace FusionCrowd::Helbing;
+
+namespace UnitTest
+{
+	TEST_CLASS(HelbingKernelUnitTest)
+	{
+	public:
+		TEST_METHOD(HelbingKernel__Sse_matches_scalar)
+		{
+			CheckAgainstScalar(KernelIsa::Sse, "SSE");
+		}
+
+		TEST_METHOD(HelbingKernel__Avx2_matches_scalar)
+		{
+			CheckAgainstScalar(KernelIsa::Avx2, "AVX2");
+		}
+
+		TEST_METHOD(HelbingKernel__No_neighbors_no_force)
+		{
+			const NeighborArrays neighbors { nullptr, nullptr, nullptr, nullptr, nullptr, 0 };
+			const KernelIsa isas[] = { KernelIsa::Scalar, KernelIsa::Sse, KernelIsa::Avx2 };
+			for (KernelIsa isa : isas)
+			{
+				float forceX = 1.f, forceY = 1.f;
+				AgentForces(isa, PARAMS, 0.f, 0.f, 1.f, 0.f, 0.2f, neighbors, forceX, forceY);
+
+				Assert::IsTrue(forceX == 0.f && forceY == 0.f);
+			}
+		}
+
+	private:
+		// Relative to the sum of pair force magnitudes, covers exp approximation and summation order
+		static constexpr float TOLERANCE = 1e-5f;
+		static const size_t CHECKS = 10000;
+		static const size_t MAX_NEIGHBORS = 64;
+
+		// HelbingComponent defaults
+		const ForceParams PARAMS { 2000.f, 0.08f, 1.2e5f, 2.4e5f };
+
+		// Unsupported instruction sets fall back to a narrower path, there is nothing to compare then
+		void CheckAgainstScalar(KernelIsa isa, const char * name)
+		{
+			if (isa > BestAvailableIsa())
+			{
+				Logger::WriteMessage((std::string(name) + " is not supported on this machine, skipped").c_str());
+				return;
+			}
+
+			std::mt19937 rnd(42);
+			auto uniform = [&rnd](float min, float max) { return std::uniform_real_distribution<float>(min, max)(rnd); };
+
+			std::vector<float> posX, posY, velX, velY, radius;
+			float maxError = 0.f;
+			for (size_t check = 0; check < CHECKS; check++)
+			{
+				const size_t count = std::uniform_int_distribution<size_t>(0, MAX_NEIGHBORS)(rnd);
+				const float x = uniform(-3.f, 3.f);
+				const float y = uniform(-3.f, 3.f);
+				const float vx = uniform(-1.5f, 1.5f);
+				const float vy = uniform(-1.5f, 1.5f);
+				const float r = uniform(0.15f, 0.3f);
+
+				posX.resize(count);
+				posY.resize(count);
+				velX.resize(count);
+				velY.resize(count);
+				radius.resize(count);
+
+				double magnitudes = 1.0;
+				for (size_t i = 0; i < count; i++)
+				{
+					posX[i] = uniform(-3.f, 3.f);
+					posY[i] = uniform(-3.f, 3.f);
+					velX[i] = uniform(-1.5f, 1.5f);
+					velY[i] = uniform(-1.5f, 1.5f);
+					radius[i] = uniform(0.15f, 0.3f);
+
+					const double dist = std::hypot(x - posX[i], y - posY[i]);
+					const double pen = std::max(0.0, r + radius[i] - dist);
+					magnitudes += std::min(PARAMS.agentScale * std::exp((r + radius[i] - dist) / PARAMS.forceDistance), 1e15)
+						+ pen * (PARAMS.bodyForce + PARAMS.friction * 6.0);
+				}
+
+				// The agent itself is among its neighbours in the simulation
+				if (count > 0)
+				{
+					posX[0] = x;
+					posY[0] = y;
+				}
+
+				const NeighborArrays neighbors { posX.data(), posY.data(), velX.data(), velY.data(), radius.data(), count };
+
+				float expectedX, expectedY;
+				AgentForces(KernelIsa::Scalar, PARAMS, x, y, vx, vy, r, neighbors, expectedX, expectedY);
+
+				float actualX, actualY;
+				AgentForces(isa, PARAMS, x, y, vx, vy, r, neighbors, actualX, actualY);
+
+				maxError = std::max(maxError, (float) (std::hypot(actualX - expectedX, actualY - expectedY) / magnitudes));
+			}
+
+			Assert::IsTrue(maxError <= TOLERANCE, L"Vector kernel is off the scalar one by more than the tolerance.");
+		}
+	};
+}
@@ -3,12 +3,20 @@
 #include "resources_util.h"
 
 #include <fstream>
+#include <memory>
+#include <vector>
 
 #include "Navigation/NavMesh/NavMesh.h"
+#include "Navigation/NavMesh/NavMeshLocalizer.h"
+#include "Navigation/NavMesh/Modification/ModificationProcessor.h"
+#include "Navigation/SpatialQuery/NavMeshSpatialQuery.h"
+#include "TacticComponent/NavMesh/Path/PathPlanner.h"
+#include "TacticComponent/NavMesh/Path/Route.h"
 
 
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 
+using namespace DirectX::SimpleMath;
 using namespace FusionCrowd;
 
 namespace UnitTest
@@ -27,5 +35,75 @@ namespace UnitTest
 			Assert::IsTrue(0 == navMesh->GetEdgesCount());
 			Assert::IsTrue(4 == navMesh->GetVertexCount());
 		}
+
+		TEST_METHOD(NavMesh__CutInvalidatesOnlyRoutesThroughDeletedNodes)
+		{
+			auto localizer = std::make_shared<NavMeshLocalizer>(GetDirectoryName(__FILE__) + "t-shaped-fancy.nav", true);
+			auto navMesh = localizer->getNavMesh();
+			auto planner = localizer->getPlanner();
+			const unsigned int nodeCount = (unsigned int) navMesh->getNodeCount();
+
+			std::vector<PortalRoutePtr> routes;
+			std::vector<std::vector<Vector2>> portalPoints;
+			for (unsigned int start = 0; start < nodeCount; start++)
+			{
+				for (unsigned int end = 0; end < nodeCount; end++)
+				{
+					auto route = planner->getRoute(start, end, 0.38f);
+					std::vector<Vector2> points;
+					for (size_t i = 0; i < route->getPortalCount(); i++)
+					{
+						points.push_back(route->getPortal(i)->getLeft());
+						points.push_back(route->getPortal(i)->getRight());
+					}
+					routes.push_back(route);
+					portalPoints.push_back(points);
+				}
+			}
+
+			const Vector2 center = navMesh->GetNodeByPos(CUT_NODE).getCenter();
+			std::vector<Vector2> polygon {
+				center + Vector2(-0.3f, -0.3f),
+				center + Vector2(0.3f, -0.3f),
+				center + Vector2(0.3f, 0.3f),
+				center + Vector2(-0.3f, 0.3f)
+			};
+			NavMeshSpatialQuery query(localizer);
+			FusionCrowd::ModificationProcessor processor(*navMesh, localizer, &query);
+			processor.CutPolygonFromMesh(polygon);
+
+			size_t invalid = 0;
+			for (size_t r = 0; r < routes.size(); r++)
+			{
+				const PortalRoute & route = *routes[r];
+				bool throughDeleted = navMesh->GetNodeByPos(route.getStartNode()).deleted
+					|| navMesh->GetNodeByPos(route.getEndNode()).deleted;
+				for (size_t i = 0; i < route.getPortalCount(); i++)
+				{
+					throughDeleted = throughDeleted || navMesh->GetNodeByPos(route.getPortalNode(i)).deleted;
+				}
+
+				Assert::IsTrue(route.IsValid(*navMesh) != throughDeleted, L"Route validity does not match deleted nodes.");
+				if (throughDeleted)
+				{
+					invalid++;
+					continue;
+				}
+
+				// Portals keep their own copy of the edge, mesh edges may be reallocated by the cut
+				for (size_t i = 0; i < route.getPortalCount(); i++)
+				{
+					Assert::IsTrue(portalPoints[r][2 * i] == route.getPortal(i)->getLeft(), L"Portal of a valid route moved.");
+					Assert::IsTrue(portalPoints[r][2 * i + 1] == route.getPortal(i)->getRight(), L"Portal of a valid route moved.");
+				}
+			}
+
+			Assert::IsTrue(invalid > 0, L"Cut should invalidate some routes.");
+			Assert::IsTrue(invalid < routes.size(), L"Cut should leave some routes valid.");
+		}
+
+	private:
+		// Only some of the routes pass through this node
+		static const unsigned int CUT_NODE = 27;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,164 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include "resources_util.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include "Export/ComponentId.h"
+#include "Export/Export.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+using namespace FusionCrowd;
+
+namespace UnitTest
+{
+	// Scenes run on one thread and on several must give bit-identical trajectories
+	TEST_CLASS(ParallelDeterminismUnitTest)
+	{
+	public:
+		TEST_METHOD(ParallelDeterminism__Karamouzas)
+		{
+			CheckOp(ComponentIds::KARAMOUZAS_ID);
+		}
+
+		TEST_METHOD(ParallelDeterminism__Helbing)
+		{
+			CheckOp(ComponentIds::HELBING_ID);
+		}
+
+		TEST_METHOD(ParallelDeterminism__ORCA)
+		{
+			CheckOp(ComponentIds::ORCA_ID);
+		}
+
+		TEST_METHOD(ParallelDeterminism__Zanlungo)
+		{
+			CheckOp(ComponentIds::ZANLUNGO_ID);
+		}
+
+		TEST_METHOD(ParallelDeterminism__PedVO)
+		{
+			CheckOp(ComponentIds::PEDVO_ID);
+		}
+
+		// Every agent gets a new goal at once, so NavMesh replans them in one batch
+		TEST_METHOD(ParallelDeterminism__Batched_replanning)
+		{
+			Compare(RunGoalChange(1), RunGoalChange(THREADS));
+		}
+
+	private:
+		static const size_t AGENTS = 100;
+		static const size_t STEPS = 100;
+		static const size_t THREADS = 4;
+		static const unsigned int SEED = 42;
+
+		static const size_t GOAL_CHANGE_STEP = 30;
+
+		void CheckOp(ComponentId op)
+		{
+			Compare(Run(op, 1), Run(op, THREADS));
+		}
+
+		void Compare(const std::vector<AgentInfo> & serial, const std::vector<AgentInfo> & parallel)
+		{
+			Assert::IsTrue(serial.size() == parallel.size(), L"Runs have different agent counts.");
+			for (size_t i = 0; i < serial.size(); i++)
+			{
+				const AgentInfo & expected = serial[i];
+				const AgentInfo & actual = parallel[i];
+
+				Assert::IsTrue(expected.id == actual.id
+					&& expected.posX == actual.posX && expected.posY == actual.posY
+					&& expected.velX == actual.velX && expected.velY == actual.velY
+					&& expected.orientX == actual.orientX && expected.orientY == actual.orientY,
+					L"Serial and parallel trajectories differ.");
+			}
+		}
+
+		// Exchange circle on the open square
+		std::vector<AgentInfo> Run(ComponentId op, size_t threadCount)
+		{
+			std::shared_ptr<ISimulatorBuilder> builder(BuildSimulator(), BuilderDeleter);
+			builder
+				->WithNavMesh((GetDirectoryName(__FILE__) + "square.nav").c_str())
+				->WithOp(op)
+				->WithThreadCount(threadCount);
+
+			std::shared_ptr<ISimulatorFacade> sim(builder->Build(), SimulatorFacadeDeleter);
+
+			const float gap = 0.1f;
+			const float bigR = AGENTS * (2 * 0.19f + gap) / 6.28f;
+			const float dAlpha = 6.28f / AGENTS;
+			for (size_t i = 0; i < AGENTS; i++)
+			{
+				const float alpha = dAlpha * i;
+				const float oppositeAlpha = alpha + 3.1415f;
+
+				size_t id = sim->AddAgent(bigR * cos(alpha), bigR * sin(alpha), op, ComponentIds::NAVMESH_ID, ComponentIds::NO_COMPONENT);
+				sim->SetAgentGoal(id, Point { bigR * cos(oppositeAlpha), bigR * sin(oppositeAlpha) });
+			}
+
+			return Steps(sim, STEPS);
+		}
+
+		// Both ends of the T head to the far arm, then swap to each other's start halfway
+		std::vector<AgentInfo> RunGoalChange(size_t threadCount)
+		{
+			std::shared_ptr<ISimulatorBuilder> builder(BuildSimulator(), BuilderDeleter);
+			builder
+				->WithNavMesh((GetDirectoryName(__FILE__) + "t-shaped-fancy.nav").c_str())
+				->WithOp(ComponentIds::KARAMOUZAS_ID)
+				->WithThreadCount(threadCount);
+
+			std::shared_ptr<ISimulatorFacade> sim(builder->Build(), SimulatorFacadeDeleter);
+
+			std::vector<size_t> ids;
+			for (size_t i = 0; i < AGENTS; i++)
+			{
+				const bool bottom = i % 2 == 0;
+				const float x = 1.f + 0.6f * ((i / 2) % 10);
+				const float y = (bottom ? 1.f : 16.f) + 0.4f * ((i / 2) / 10);
+
+				size_t id = sim->AddAgent(x, y, ComponentIds::KARAMOUZAS_ID, ComponentIds::NAVMESH_ID, ComponentIds::NO_COMPONENT);
+				sim->SetAgentGoal(id, Point { 28.f, 11.5f });
+				ids.push_back(id);
+			}
+
+			std::vector<AgentInfo> states = Steps(sim, GOAL_CHANGE_STEP);
+			for (size_t i = 0; i < ids.size(); i++)
+			{
+				const bool bottom = i % 2 == 0;
+				sim->SetAgentGoal(ids[i], bottom ? Point { 2.5f, 17.f } : Point { 4.f, 2.f });
+			}
+
+			std::vector<AgentInfo> rest = Steps(sim, STEPS - GOAL_CHANGE_STEP);
+			states.insert(states.end(), rest.begin(), rest.end());
+
+			return states;
+		}
+
+		// States of all agents after every step
+		std::vector<AgentInfo> Steps(std::shared_ptr<ISimulatorFacade> sim, size_t steps)
+		{
+			// Some models draw from rand(), every run starts from the same seed
+			srand(SEED);
+
+			std::vector<AgentInfo> states;
+			FCArray<AgentInfo> agents(sim->GetAgentCount());
+			for (size_t step = 0; step < steps; step++)
+			{
+				sim->DoStep();
+
+				sim->GetAgents(agents);
+				states.insert(states.end(), agents.begin(), agents.end());
+			}
+
+			return states;
+		}
+	};
+}
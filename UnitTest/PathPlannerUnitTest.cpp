@@ -0,0 +1,154 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include "resources_util.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "Navigation/NavMesh/NavMesh.h"
+#include "Navigation/NavMesh/NavMeshLocalizer.h"
+#include "Navigation/NavMesh/Modification/ModificationProcessor.h"
+#include "Navigation/SpatialQuery/NavMeshSpatialQuery.h"
+#include "Math/Shapes/PointShape.h"
+#include "StrategyComponent/Goal/Goal.h"
+#include "TacticComponent/NavMesh/Path/PathPlanner.h"
+#include "TacticComponent/NavMesh/Path/PortalPath.h"
+#include "TacticComponent/NavMesh/Path/Route.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+using namespace DirectX::SimpleMath;
+using namespace FusionCrowd;
+
+namespace UnitTest
+{
+	TEST_CLASS(PathPlannerUnitTest)
+	{
+	public:
+		TEST_METHOD(PathPlanner__ConcurrentRequestsShareCachedRoute)
+		{
+			auto localizer = std::make_shared<NavMeshLocalizer>(GetDirectoryName(__FILE__) + "t-shaped-fancy.nav", true);
+			auto planner = localizer->getPlanner();
+			const unsigned int nodeCount = (unsigned int) localizer->getNavMesh()->getNodeCount();
+
+			// Every thread asks for the same keys in the same order, so some of them
+			// miss the cache on a key another thread is planning at the moment
+			const size_t THREADS = 8;
+			std::vector<std::vector<PortalRoutePtr>> routes(THREADS);
+			std::atomic<size_t> ready(0);
+			std::vector<std::thread> threads;
+			for (size_t t = 0; t < THREADS; t++)
+			{
+				threads.emplace_back([&, t]()
+				{
+					ready++;
+					while (ready < THREADS)
+						std::this_thread::yield();
+
+					for (unsigned int start = 0; start < nodeCount; start++)
+						for (unsigned int end = 0; end < nodeCount; end++)
+							routes[t].push_back(planner->getRoute(start, end, AGENT_WIDTH));
+				});
+			}
+			for (auto & thread : threads)
+				thread.join();
+
+			for (size_t t = 1; t < THREADS; t++)
+			{
+				Assert::IsTrue(routes[0] == routes[t], L"Threads got different routes for the same key.");
+			}
+			Assert::IsTrue(nodeCount * nodeCount == planner->GetCacheStats().routes, L"Same route is cached more than once.");
+		}
+
+		TEST_METHOD(PathPlanner__ReplanDropsRouteThroughCutNode)
+		{
+			auto localizer = std::make_shared<NavMeshLocalizer>(GetDirectoryName(__FILE__) + "t-shaped-fancy.nav", true);
+			auto navMesh = localizer->getNavMesh();
+			auto planner = localizer->getPlanner();
+
+			auto route = planner->getRoute(START_NODE, END_NODE, AGENT_WIDTH);
+			Assert::IsTrue(route->getPortalCount() > 1, L"Route is too short to cut.");
+
+			const Vector2 center = navMesh->GetNodeByPos(route->getPortalNode(route->getPortalCount() / 2)).getCenter();
+			CutSquare(localizer, center, 0.3f);
+			Assert::IsFalse(route->IsValid(*navMesh), L"Route through a cut node is still valid.");
+
+			auto replanned = planner->getRoute(START_NODE, END_NODE, AGENT_WIDTH);
+			Assert::IsTrue(replanned->IsValid(*navMesh), L"Replanning returned a route through a deleted node.");
+			Assert::IsTrue(1 == planner->GetCacheStats().routes, L"Route through a deleted node is still cached.");
+		}
+
+		TEST_METHOD(PathPlanner__EvictionKeepsByteBudget)
+		{
+			auto localizer = std::make_shared<NavMeshLocalizer>(GetDirectoryName(__FILE__) + "t-shaped-fancy.nav", true);
+			auto planner = localizer->getPlanner();
+			const unsigned int nodeCount = (unsigned int) localizer->getNavMesh()->getNodeCount();
+
+			const size_t BUDGET = 16 * 1024;
+			planner->SetCacheBudget(BUDGET);
+			for (unsigned int start = 0; start < nodeCount; start++)
+			{
+				for (unsigned int end = 0; end < nodeCount; end++)
+				{
+					planner->getRoute(start, end, AGENT_WIDTH);
+					Assert::IsTrue(planner->GetCacheStats().bytesUsed <= BUDGET, L"Route cache is over its byte budget.");
+				}
+			}
+
+			const RouteCacheStats stats = planner->GetCacheStats();
+			Assert::IsTrue(stats.evictions > 0, L"Routes of the whole mesh should not fit into the budget.");
+			Assert::IsTrue(stats.routes + stats.evictions == stats.misses, L"Every planned route is either cached or evicted.");
+		}
+
+		TEST_METHOD(PathPlanner__EvictedRouteStaysAliveInPath)
+		{
+			auto localizer = std::make_shared<NavMeshLocalizer>(GetDirectoryName(__FILE__) + "t-shaped-fancy.nav", true);
+			auto navMesh = localizer->getNavMesh();
+			auto planner = localizer->getPlanner();
+
+			auto route = planner->getRoute(START_NODE, END_NODE, AGENT_WIDTH);
+			const size_t portalCount = route->getPortalCount();
+			const PointGoal goal(navMesh->GetNodeByPos(END_NODE).getCenter());
+			auto path = std::make_shared<PortalPath>(navMesh->GetNodeByPos(START_NODE).getCenter(), goal, route, AGENT_WIDTH / 2);
+
+			std::weak_ptr<PortalRoute> observer = route;
+			route.reset();
+
+			planner->SetCacheBudget(0);
+			Assert::IsTrue(0 == planner->GetCacheStats().routes, L"Zero budget should evict every route.");
+			Assert::IsFalse(observer.expired(), L"Evicted route was freed while a path holds it.");
+			Assert::IsTrue(portalCount == path->getPortalCount(), L"Path lost its route.");
+
+			path.reset();
+			Assert::IsTrue(observer.expired(), L"Route outlived the last path holding it.");
+		}
+
+	private:
+		// GoalFactory is only available to Simulator
+		struct PointGoal : public Goal
+		{
+			PointGoal(Vector2 p) : Goal(0, std::make_unique<Math::PointShape>(p)) { }
+		};
+
+		// Far ends of the T
+		static const unsigned int START_NODE = 34;
+		static const unsigned int END_NODE = 1;
+		static constexpr float AGENT_WIDTH = 0.38f;
+
+		static void CutSquare(std::shared_ptr<NavMeshLocalizer> localizer, Vector2 center, float halfSide)
+		{
+			NavMeshSpatialQuery query(localizer);
+			FusionCrowd::ModificationProcessor processor(*localizer->getNavMesh(), localizer, &query);
+
+			std::vector<Vector2> polygon {
+				center + Vector2(-halfSide, -halfSide),
+				center + Vector2(halfSide, -halfSide),
+				center + Vector2(halfSide, halfSide),
+				center + Vector2(-halfSide, halfSide)
+			};
+			processor.CutPolygonFromMesh(polygon);
+		}
+	};
+}
@@ -0,0 +1,93 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include <cmath>
+#include <vector>
+
+#include "Math/consts.h"
+#include "Navigation/NeighborInfo.h"
+#include "OperationComponent/Zanlungo/ZanlungoInteraction.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+using namespace DirectX::SimpleMath;
+using namespace FusionCrowd;
+using namespace FusionCrowd::Zanlungo;
+
+namespace UnitTest
+{
+	TEST_CLASS(ZanlungoInteractionUnitTest)
+	{
+	public:
+		TEST_METHOD(ZanlungoInteraction__Head_on_pushes_back)
+		{
+			// Disks of 0.4 combined radius close 4.6 apart at relative speed 2
+			std::vector<NeighborInfo> neighbours { Neighbour(Vector2(5.f, 0.f), Vector2(-1.f, 0.f)) };
+
+			float tti;
+			Vector2 force(1.f, 1.f);
+			const bool interacts = AgentInteraction(PARAMS, Vector2(0.f, 0.f), Vector2(1.f, 0.f), RADIUS, neighbours, Math::INFTY, TIME_STEP, tti, force);
+
+			Assert::IsTrue(interacts);
+			Assert::IsTrue(std::abs(tti - 2.3f) < 1e-5f, L"Wrong time to interaction.");
+
+			// Disks touch at T_i, so the force is the full magnitude along -x added to what was there
+			const float expected = PARAMS.agentScale * 2.f / 2.3f;
+			Assert::IsTrue(std::abs(force.x - (1.f - expected)) < expected * 1e-4f, L"Wrong force magnitude.");
+			Assert::IsTrue(force.y == 1.f, L"Head-on force has a side component.");
+		}
+
+		TEST_METHOD(ZanlungoInteraction__Diverging_neighbour_is_ignored)
+		{
+			std::vector<NeighborInfo> neighbours { Neighbour(Vector2(-5.f, 0.f), Vector2(-1.f, 0.f)) };
+
+			float tti;
+			Vector2 force(1.f, 1.f);
+			const bool interacts = AgentInteraction(PARAMS, Vector2(0.f, 0.f), Vector2(1.f, 0.f), RADIUS, neighbours, Math::INFTY, TIME_STEP, tti, force);
+
+			Assert::IsFalse(interacts);
+			Assert::IsTrue(force == Vector2(1.f, 1.f), L"Force changed without interaction.");
+		}
+
+		TEST_METHOD(ZanlungoInteraction__Overlap_clamps_to_time_step)
+		{
+			std::vector<NeighborInfo> neighbours { Neighbour(Vector2(0.3f, 0.f), Vector2(0.f, 0.f)) };
+
+			float tti;
+			Vector2 force(0.f, 0.f);
+			const bool interacts = AgentInteraction(PARAMS, Vector2(0.f, 0.f), Vector2(1.f, 0.f), RADIUS, neighbours, Math::INFTY, TIME_STEP, tti, force);
+
+			Assert::IsTrue(interacts);
+			Assert::IsTrue(tti == TIME_STEP);
+		}
+
+		TEST_METHOD(ZanlungoInteraction__Obstacle_alone_sets_tti)
+		{
+			std::vector<NeighborInfo> neighbours;
+
+			float tti;
+			Vector2 force(0.f, 0.f);
+			const bool interacts = AgentInteraction(PARAMS, Vector2(0.f, 0.f), Vector2(1.f, 0.f), RADIUS, neighbours, 1.5f, TIME_STEP, tti, force);
+
+			Assert::IsTrue(interacts);
+			Assert::IsTrue(tti == 1.5f);
+			Assert::IsTrue(force == Vector2(0.f, 0.f), L"Agent force without neighbours.");
+		}
+
+	private:
+		// ZanlungoComponent defaults
+		const InteractionParams PARAMS { 2000.f, 0.08f };
+		static constexpr float RADIUS = 0.2f;
+		static constexpr float TIME_STEP = 0.1f;
+
+		static NeighborInfo Neighbour(Vector2 pos, Vector2 vel)
+		{
+			NeighborInfo n;
+			n.id = 1;
+			n.pos = pos;
+			n.vel = vel;
+			n.radius = RADIUS;
+			return n;
+		}
+	};
+}
@@ -6,7 +6,7 @@
 
 #define TEST_CASE_DIRECTORY GetDirectoryName(__FILE__)
 
-std::string GetDirectoryName(std::string path) {
+inline std::string GetDirectoryName(std::string path) {
     const size_t last_slash_idx = path.rfind('\\');
     if (std::string::npos != last_slash_idx)
     {